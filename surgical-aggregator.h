@@ -0,0 +1,320 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Sweep result aggregation: per-worker lock-free queues in shared memory
+ * and confidence-interval summaries over replications
+ */
+
+#ifndef SURGICAL_AGGREGATOR_H
+#define SURGICAL_AGGREGATOR_H
+
+#include "surgical-scenario.h"
+
+namespace ns3 {
+
+// ===== Worker result queues =====
+// One single-producer, single-consumer byte ring per sweep worker, mapped
+// shared and anonymous before the fork. The worker is the only writer of
+// m_head and the parent the only writer of m_tail, so both sides only need
+// acquire/release ordering and never lock. A record is a 32-bit length and
+// its bytes; the head moves past a record only once it is complete, so a
+// worker that dies mid-record leaves nothing half-written behind. A full
+// ring makes the worker wait for the parent to drain it.
+
+class SweepQueue
+{
+public:
+  // Map a queue with 'capacity' bytes of ring; Unmap () releases it
+  static SweepQueue* Map (uint64_t capacity);
+  static void Unmap (SweepQueue* queue);
+
+  // Producer side
+  void Push (const std::string& record);
+  // Consumer side: false when the ring is empty
+  bool Pop (std::string& record);
+
+private:
+  SweepQueue () = default;
+  char* Ring ();
+  void Copy (uint64_t pos, const char* from, uint64_t n);
+  void CopyOut (uint64_t pos, char* to, uint64_t n);
+
+  static_assert (std::atomic<uint64_t>::is_always_lock_free,
+                 "the sweep queue needs address-free 64-bit atomics");
+  alignas (64) std::atomic<uint64_t> m_head;  // bytes ever written
+  alignas (64) std::atomic<uint64_t> m_tail;  // bytes ever read
+  uint64_t m_capacity;
+};
+
+inline SweepQueue* SweepQueue::Map (uint64_t capacity)
+{
+  void* memory = mmap (nullptr, sizeof (SweepQueue) + capacity, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED)
+    {
+      NS_FATAL_ERROR ("mmap of a " << capacity << " byte sweep queue failed: " << std::strerror (errno));
+    }
+  SweepQueue* queue = new (memory) SweepQueue ();
+  queue->m_head.store (0);
+  queue->m_tail.store (0);
+  queue->m_capacity = capacity;
+  return queue;
+}
+
+inline void SweepQueue::Unmap (SweepQueue* queue)
+{
+  munmap (queue, sizeof (SweepQueue) + queue->m_capacity);
+}
+
+inline char* SweepQueue::Ring ()
+{
+  return reinterpret_cast<char*> (this) + sizeof (SweepQueue);
+}
+
+inline void SweepQueue::Copy (uint64_t pos, const char* from, uint64_t n)
+{
+  uint64_t at = pos % m_capacity;
+  uint64_t first = std::min (n, m_capacity - at);
+  std::memcpy (Ring () + at, from, first);
+  std::memcpy (Ring (), from + first, n - first);
+}
+
+inline void SweepQueue::CopyOut (uint64_t pos, char* to, uint64_t n)
+{
+  uint64_t at = pos % m_capacity;
+  uint64_t first = std::min (n, m_capacity - at);
+  std::memcpy (to, Ring () + at, first);
+  std::memcpy (to + first, Ring (), n - first);
+}
+
+inline void SweepQueue::Push (const std::string& record)
+{
+  uint32_t length = record.size ();
+  uint64_t needed = sizeof (length) + length;
+  NS_ABORT_MSG_IF (needed > m_capacity, "sweep record of " << length << " bytes exceeds the queue");
+
+  uint64_t head = m_head.load (std::memory_order_relaxed);
+  while (m_capacity - (head - m_tail.load (std::memory_order_acquire)) < needed)
+    {
+      usleep (100);
+    }
+  Copy (head, reinterpret_cast<const char*> (&length), sizeof (length));
+  Copy (head + sizeof (length), record.data (), length);
+  m_head.store (head + needed, std::memory_order_release);
+}
+
+inline bool SweepQueue::Pop (std::string& record)
+{
+  uint64_t tail = m_tail.load (std::memory_order_relaxed);
+  if (m_head.load (std::memory_order_acquire) == tail)
+    {
+      return false;
+    }
+  uint32_t length = 0;
+  CopyOut (tail, reinterpret_cast<char*> (&length), sizeof (length));
+  record.resize (length);
+  CopyOut (tail + sizeof (length), &record[0], length);
+  m_tail.store (tail + sizeof (length) + length, std::memory_order_release);
+  return true;
+}
+
+// ===== Replication summaries =====
+
+// Mean and variance of one metric over replications (Welford)
+struct RunningStat {
+  uint32_t n = 0;
+  double mean = 0.0;
+  double m2 = 0.0;
+
+  void Add (double x);
+  double Stddev () const;
+  // Half-width of the two-sided 95% Student-t confidence interval of the
+  // mean; 0 with fewer than two replications
+  double Ci95 () const;
+};
+
+// Two-sided 95% Student-t critical value for 'df' degrees of freedom:
+// tabulated up to 30, interpolated in 1/df above
+inline double StudentT95 (uint32_t df)
+{
+  static const double table[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+  if (df == 0)
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  if (df <= 30)
+    {
+      return table[df - 1];
+    }
+  static const double dfs[] = {30, 40, 60, 120};
+  static const double ts[] = {2.042, 2.021, 2.000, 1.980};
+  double x = 1.0 / df;
+  for (uint32_t i = 1; i < 4; ++i)
+    {
+      if (df <= dfs[i])
+        {
+          double x0 = 1.0 / dfs[i - 1], x1 = 1.0 / dfs[i];
+          return ts[i - 1] + (ts[i] - ts[i - 1]) * (x - x0) / (x1 - x0);
+        }
+    }
+  return 1.960 + (1.980 - 1.960) * x * 120.0;
+}
+
+inline void RunningStat::Add (double x)
+{
+  ++n;
+  double delta = x - mean;
+  mean += delta / n;
+  m2 += delta * (x - mean);
+}
+
+inline double RunningStat::Stddev () const
+{
+  return (n > 1) ? std::sqrt (m2 / (n - 1)) : 0.0;
+}
+
+inline double RunningStat::Ci95 () const
+{
+  return (n > 1) ? StudentT95 (n - 1) * Stddev () / std::sqrt (n) : 0.0;
+}
+
+// One device and direction of one sweep scenario over its replications
+struct DeviceSummary {
+  DeviceMetrics device;  // first replication's row: name, class, room, direction
+  RunningStat avgLatencyMs;
+  RunningStat p99LatencyMs;
+  RunningStat lossPercent;
+  RunningStat successPercent;
+  RunningStat energyJ;  // battery stations only, 0 otherwise
+  RunningStat batteryLifeHours;
+  uint32_t completed = 0;
+  LatencyHistogram pooled;  // every packet of every replication
+};
+
+struct ScenarioSummary {
+  ScenarioConfig config;  // of the first replication
+  uint32_t replications = 0;
+  bool converged = false;  // adaptive replication met its CI targets
+  uint32_t lostRuns = 0;  // replications given up after their workers died
+  uint32_t safetyStops = 0;
+  RunningStat wallSeconds;
+  std::vector<DeviceSummary> devices;  // in device-plan order
+};
+
+// Folds finished runs into per-scenario summaries as they arrive, so the
+// parent only ever holds one summary per scenario and device
+class SweepAggregator
+{
+public:
+  void Add (uint32_t scenario, const ScenarioConfig& config, const ScenarioResult& result);
+  const std::map<uint32_t, ScenarioSummary>& GetSummaries () const;
+  ScenarioSummary& GetSummary (uint32_t scenario);
+
+private:
+  std::map<uint32_t, ScenarioSummary> m_summaries;
+};
+
+inline void SweepAggregator::Add (uint32_t scenario, const ScenarioConfig& config,
+                                  const ScenarioResult& result)
+{
+  auto inserted = m_summaries.emplace (scenario, ScenarioSummary ());
+  ScenarioSummary& s = inserted.first->second;
+  if (inserted.second)
+    {
+      s.config = config;
+    }
+  ++s.replications;
+  s.safetyStops += result.safety.stopped ? 1 : 0;
+  s.wallSeconds.Add (result.wallSeconds);
+
+  std::map<std::string, uint32_t> taskTargets = BuildTaskTargets (config);
+  for (const auto& r : result.devices)
+    {
+      auto d = std::find_if (s.devices.begin (), s.devices.end (), [&r] (const DeviceSummary& x) {
+        return x.device.name == r.name && x.device.direction == r.direction;
+      });
+      if (d == s.devices.end ())
+        {
+          s.devices.push_back (DeviceSummary ());
+          d = s.devices.end () - 1;
+          d->device = r;
+          d->device.latency = LatencyHistogram ();
+        }
+      uint32_t target = taskTargets.at (r.name);
+      d->avgLatencyMs.Add (r.avgLatencyMs);
+      d->p99LatencyMs.Add (r.latency.GetQuantileMs (0.99));
+      d->lossPercent.Add (r.lossRate);
+      d->successPercent.Add ((target > 0) ? (double)r.rxPackets / target * 100.0 : 0.0);
+      d->energyJ.Add (r.energyJ);
+      d->batteryLifeHours.Add (r.batteryLifeHours);
+      d->completed += r.taskCompleted ? 1 : 0;
+      d->pooled.Merge (r.latency);
+    }
+}
+
+inline const std::map<uint32_t, ScenarioSummary>& SweepAggregator::GetSummaries () const
+{
+  return m_summaries;
+}
+
+inline ScenarioSummary& SweepAggregator::GetSummary (uint32_t scenario)
+{
+  return m_summaries.at (scenario);
+}
+
+// ===== Adaptive replication =====
+// How many replications a sweep scenario gets. With both CI targets at 0
+// every scenario runs maxReplications times. Otherwise replications go on
+// until the 95% CI half-width of the per-run robot p99 latency is at most
+// ciP99Ms and that of the task success rate at most ciSuccessPercent
+// points, checked from minReplications on and given up at maxReplications.
+// Only robot control rows (either direction) are watched, or every row of
+// a scenario without robot traffic.
+
+struct ReplicationPolicy {
+  uint32_t minReplications = 1;
+  uint32_t maxReplications = 1;
+  double ciP99Ms = 0.0;
+  double ciSuccessPercent = 0.0;
+
+  bool IsAdaptive () const;
+};
+
+inline bool ReplicationPolicy::IsAdaptive () const
+{
+  return ciP99Ms > 0 || ciSuccessPercent > 0;
+}
+
+inline bool IsConverged (const ScenarioSummary& s, const ReplicationPolicy& policy)
+{
+  if (!policy.IsAdaptive () || s.replications < std::max (2u, policy.minReplications))
+    {
+      return false;
+    }
+  bool robots = std::any_of (s.devices.begin (), s.devices.end (), [] (const DeviceSummary& d) {
+    return d.device.deviceClass == ROBOT_CTRL;
+  });
+  for (const auto& d : s.devices)
+    {
+      if (robots && d.device.deviceClass != ROBOT_CTRL)
+        {
+          continue;
+        }
+      if (policy.ciP99Ms > 0 && d.p99LatencyMs.Ci95 () > policy.ciP99Ms)
+        {
+          return false;
+        }
+      if (policy.ciSuccessPercent > 0 && d.successPercent.Ci95 () > policy.ciSuccessPercent)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_AGGREGATOR_H */
@@ -0,0 +1,557 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Benchmark suite: the Smart-OR scenario over a grid of station counts and
+ * simulated durations, compared against a stored throughput baseline
+ */
+
+#ifndef SURGICAL_BENCHMARK_H
+#define SURGICAL_BENCHMARK_H
+
+#include "surgical-driver.h"
+
+namespace ns3 {
+
+// ===== Benchmark suite =====
+// Every case runs in its own forked process, so peak RSS is that of the case
+// alone, with RngSeed and RngRun fixed: two builds of the same model execute
+// the same events and only their speed differs. Clients send until the end of
+// the run (no task limit), so long cases keep the channel loaded throughout.
+// Under mpirun (--distributed) the cases run in-process on every rank, since
+// MPI does not survive a fork, and rank 0 reports the wall-clock speedup over
+// the sequential baseline instead of events/s: remote beacons are simulated
+// on every rank, so the summed event count is not that of a sequential run.
+// With several --fidelities each case runs once per Wi-Fi fidelity, and the
+// latency error of a cheaper one is its mean latency relative to the high
+// fidelity run of the same case.
+
+static const uint32_t g_benchmarkSeed = 1;
+static const uint32_t g_benchmarkRngRun = 1;
+static const uint32_t g_benchmarkStationsPerRoom = 16;
+
+struct BenchmarkCase {
+  uint32_t stations;
+  double simulationTime;
+  std::string fidelity;
+};
+
+struct BenchmarkResult {
+  BenchmarkCase bench;
+  uint32_t stations = 0;  // as built; rounded up to whole rooms
+  uint64_t events = 0;
+  double wallSeconds = 0.0;
+  double peakRssMb = 0.0;
+  double meanLatencyMs = 0.0;  // over every delivered packet
+  double p99LatencyMs = 0.0;
+  double latencyErrorPercent = std::numeric_limits<double>::quiet_NaN ();  // vs high fidelity
+  bool done = false;
+};
+
+inline void SetBenchmarkLatency (BenchmarkResult& r, const ScenarioResult& result)
+{
+  LatencyHistogram all;
+  double sumMs = 0.0;
+  uint64_t rx = 0;
+  for (const auto& d : result.devices)
+    {
+      all.Merge (d.latency);
+      sumMs += d.avgLatencyMs * d.rxPackets;
+      rx += d.rxPackets;
+    }
+  r.meanLatencyMs = (rx > 0) ? sumMs / rx : 0.0;
+  r.p99LatencyMs = all.GetQuantileMs (0.99);
+}
+
+inline double EventsPerSecond (const BenchmarkResult& r)
+{
+  return (r.wallSeconds > 0) ? r.events / r.wallSeconds : 0.0;
+}
+
+// Up to 16 stations share one room; larger cases add rooms. Each room holds
+// a quarter robots (at least one), a quarter endoscopes and vitals otherwise.
+inline ScenarioConfig BenchmarkConfig (ScenarioConfig cfg, const BenchmarkCase& bench)
+{
+  cfg.rooms = (bench.stations + g_benchmarkStationsPerRoom - 1) / g_benchmarkStationsPerRoom;
+  uint32_t perRoom = (bench.stations + cfg.rooms - 1) / cfg.rooms;
+  cfg.robotsPerRoom = (perRoom + 3) / 4;
+  cfg.endoscopesPerRoom = perRoom / 4;
+  cfg.vitalsPerRoom = perRoom - cfg.robotsPerRoom - cfg.endoscopesPerRoom;
+
+  cfg.simulationTime = bench.simulationTime;
+  cfg.fidelity = bench.fidelity;
+  cfg.rngRun = g_benchmarkRngRun;
+  cfg.robotMaxPackets = std::numeric_limits<uint32_t>::max ();
+  cfg.videoMaxPackets = std::numeric_limits<uint32_t>::max ();
+  cfg.vitalMaxPackets = std::numeric_limits<uint32_t>::max ();
+
+  // Measure the model, not the instrumentation around it
+  cfg.enableNetAnim = false;
+  cfg.windowInterval = Seconds (0);
+  cfg.safetyStop = false;
+  cfg.profiling = false;
+  cfg.runId = "bench";
+  return cfg;
+}
+
+// "1,4,16" -> {1, 4, 16}
+template <typename T>
+inline std::vector<T> ParseBenchmarkList (const std::string& list, const std::string& option)
+{
+  std::vector<T> values;
+  std::istringstream in (list);
+  std::string value;
+  while (std::getline (in, value, ','))
+    {
+      if (value.empty ())
+        {
+          continue;
+        }
+      try
+        {
+          values.push_back (static_cast<T> (std::stod (value)));
+        }
+      catch (const std::exception&)
+        {
+          NS_FATAL_ERROR ("bad value '" << value << "' in --" << option);
+        }
+    }
+  NS_ABORT_MSG_IF (values.empty (), "--" << option << " lists no values");
+  return values;
+}
+
+inline std::string BenchmarkCaseFile (const std::string& output)
+{
+  return output + ".case";
+}
+
+// Run one case in a child process and read its cost back
+inline BenchmarkResult RunBenchmarkCase (const ScenarioConfig& base, const BenchmarkCase& bench,
+                                         const std::string& output)
+{
+  BenchmarkResult r;
+  r.bench = bench;
+  if (base.distributed)
+    {
+      RngSeedManager::SetSeed (g_benchmarkSeed);
+      ScenarioResult result = RunScenario (BenchmarkConfig (base, bench));
+      r.stations = result.stations;
+      r.events = result.events;
+      r.wallSeconds = result.wallSeconds;
+      r.peakRssMb = result.peakRssMb;
+      SetBenchmarkLatency (r, result);
+      r.done = true;
+      return r;
+    }
+  std::string caseFile = BenchmarkCaseFile (output);
+
+  std::cout.flush ();
+  pid_t pid = fork ();
+  if (pid < 0)
+    {
+      NS_FATAL_ERROR ("fork() failed for benchmark case " << bench.stations << " stations");
+    }
+  if (pid == 0)
+    {
+      RngSeedManager::SetSeed (g_benchmarkSeed);
+      ScenarioResult result = RunScenario (BenchmarkConfig (base, bench));
+      std::ofstream out (caseFile);
+      out << std::setprecision (std::numeric_limits<double>::max_digits10);
+      BenchmarkResult latency;
+      SetBenchmarkLatency (latency, result);
+      out << result.stations << "," << result.events << "," << result.wallSeconds << ","
+          << result.peakRssMb << "," << latency.meanLatencyMs << "," << latency.p99LatencyMs << "\n";
+      out.close ();
+      _exit (out ? 0 : 1);
+    }
+
+  int status = 0;
+  waitpid (pid, &status, 0);
+  std::ifstream in (caseFile);
+  char comma;
+  if (WIFEXITED (status) && WEXITSTATUS (status) == 0
+      && in >> r.stations >> comma >> r.events >> comma >> r.wallSeconds >> comma >> r.peakRssMb
+            >> comma >> r.meanLatencyMs >> comma >> r.p99LatencyMs)
+    {
+      r.done = true;
+    }
+  std::remove (caseFile.c_str ());
+  return r;
+}
+
+inline void ExportBenchmarkToCSV (const std::vector<BenchmarkResult>& results, const std::string& path)
+{
+  std::ofstream csvFile (path);
+  if (!csvFile.is_open ())
+    {
+      NS_LOG_ERROR ("Failed to open " << path << " for writing");
+      return;
+    }
+  csvFile << std::setprecision (std::numeric_limits<double>::max_digits10);
+  csvFile << "CaseStations,SimulationTime,Stations,Events,WallSeconds,EventsPerSecond,"
+          << "WallPerSimulatedSecond,PeakRssMb,Fidelity,MeanLatencyMs,P99LatencyMs,LatencyErrorPercent\n";
+  for (const auto& r : results)
+    {
+      if (!r.done)
+        {
+          continue;
+        }
+      csvFile << r.bench.stations << "," << r.bench.simulationTime << "," << r.stations << ","
+              << r.events << "," << r.wallSeconds << "," << EventsPerSecond (r) << ","
+              << r.wallSeconds / r.bench.simulationTime << "," << r.peakRssMb << ","
+              << r.bench.fidelity << "," << r.meanLatencyMs << "," << r.p99LatencyMs << ",";
+      if (!std::isnan (r.latencyErrorPercent))
+        {
+          csvFile << r.latencyErrorPercent;
+        }
+      csvFile << "\n";
+    }
+}
+
+// Baseline rows keyed by (case stations, simulation time, fidelity); rows
+// from before the Fidelity column are "default". A missing file is an empty
+// baseline.
+typedef std::map<std::tuple<uint32_t, double, std::string>, BenchmarkResult> BenchmarkBaseline;
+
+inline BenchmarkBaseline LoadBenchmarkBaseline (const std::string& path)
+{
+  BenchmarkBaseline baseline;
+  std::ifstream in (path);
+  std::string line;
+  std::getline (in, line);  // header
+  while (std::getline (in, line))
+    {
+      std::istringstream row (line);
+      std::string field;
+      std::vector<std::string> f;
+      while (std::getline (row, field, ','))
+        {
+          f.push_back (field);
+        }
+      if (f.size () < 5)
+        {
+          continue;
+        }
+      BenchmarkResult r;
+      r.bench.stations = std::stoul (f[0]);
+      r.bench.simulationTime = std::stod (f[1]);
+      r.stations = std::stoul (f[2]);
+      r.events = std::stoull (f[3]);
+      r.wallSeconds = std::stod (f[4]);
+      r.bench.fidelity = (f.size () > 8) ? f[8] : "default";
+      r.done = true;
+      baseline[std::make_tuple (r.bench.stations, r.bench.simulationTime, r.bench.fidelity)] = r;
+    }
+  return baseline;
+}
+
+// ===== Collector microbenchmark =====
+// Drives the collector's trace sinks directly, outside any simulation, with
+// a ring of prebuilt packets spread over 'flows' flows, and reports the time
+// and heap allocations per packet (one send plus one receive) of each path.
+// Allocations are counted by the operator new of surgical-iomt-bench.cc.
+// The packet tag path is there for comparison; every other path must not
+// allocate at all.
+
+extern std::atomic<uint64_t> g_benchmarkAllocations;
+
+struct CollectorBenchmark {
+  std::string path;
+  bool allocationFree;  // expected to allocate nothing per packet
+  double nsPerPacket;
+  double allocationsPerPacket;
+};
+
+template <typename Step>
+inline CollectorBenchmark TimeCollectorPath (const std::string& path, bool allocationFree, uint32_t packets,
+                                             Step step)
+{
+  // Warm up first: the simulator singleton and first-touch pages are not
+  // per-packet costs
+  for (uint32_t i = 0; i < 1024; ++i)
+    {
+      step (i);
+    }
+  uint64_t allocations = g_benchmarkAllocations.load ();
+  auto start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < packets; ++i)
+    {
+      step (i);
+    }
+  double ns = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now () - start).count ();
+  allocations = g_benchmarkAllocations.load () - allocations;
+  return {path, allocationFree, ns / packets, static_cast<double> (allocations) / packets};
+}
+
+// Exit status 1 when an allocation-free path allocated
+inline int RunCollectorBenchmark (uint32_t packets, uint32_t flows)
+{
+  NS_ABORT_MSG_IF (flows == 0, "--collectorFlows must be positive");
+  const uint32_t ring = 4096;
+  std::vector<Ptr<Packet>> echo;
+  std::vector<Ptr<Packet>> surgical;
+  for (uint32_t i = 0; i < ring; ++i)
+    {
+      echo.push_back (Create<Packet> (64));
+      SurgicalHeader header;
+      header.m_flow = i % flows;
+      Ptr<Packet> packet = Create<Packet> (32);
+      packet->AddHeader (header);
+      surgical.push_back (packet);
+    }
+  Address from = InetSocketAddress (Ipv4Address ("192.168.1.1"), 8000);
+
+  std::vector<CollectorBenchmark> results;
+  {
+    LatencyCollector collector (flows);
+    results.push_back (TimeCollectorPath ("echo, stamp pool", true, packets, [&] (uint32_t i) {
+      LatencyCollector::ClientTx (&collector, i % flows, echo[i % ring]);
+      collector.ServerRx (echo[i % ring]);
+    }));
+  }
+  {
+    LatencyCollector collector (flows);
+    collector.SetStampTags (true);
+    results.push_back (TimeCollectorPath ("echo, packet tag", false, packets, [&] (uint32_t i) {
+      LatencyCollector::ClientTx (&collector, i % flows, echo[i % ring]);
+      collector.ServerRx (echo[i % ring]);
+      echo[i % ring]->RemoveAllPacketTags ();  // as UdpEchoServer does
+    }));
+  }
+  {
+    LatencyCollector collector (flows);
+    results.push_back (TimeCollectorPath ("surgical header", true, packets, [&] (uint32_t i) {
+      collector.SourceTx (surgical[i % ring]);
+      collector.SinkRx (surgical[i % ring], from);
+    }));
+  }
+  {
+    const std::string tracePath = "surgical_collector_trace.bin";
+    unlink (tracePath.c_str ());
+    LatencyCollector collector (flows);
+    PacketTraceWriter trace (tracePath, 1, 1 << 20);
+    collector.SetPacketTrace (&trace);
+    results.push_back (TimeCollectorPath ("surgical header + trace", true, packets, [&] (uint32_t i) {
+      collector.SourceTx (surgical[i % ring]);
+      collector.SinkRx (surgical[i % ring], from);
+    }));
+    trace.Close ();
+    unlink (tracePath.c_str ());
+  }
+  Simulator::Destroy ();
+
+  std::cout << "🏁 Collector microbenchmark: " << packets << " packets over " << flows << " flows\n\n";
+  std::cout << std::left << std::setw (26) << "Path" << std::right << std::setw (12) << "ns/packet"
+            << std::setw (15) << "allocs/packet" << "\n";
+  int status = 0;
+  for (const auto& r : results)
+    {
+      std::cout << std::left << std::setw (26) << r.path << std::right << std::fixed
+                << std::setw (12) << std::setprecision (1) << r.nsPerPacket
+                << std::setw (15) << std::setprecision (3) << r.allocationsPerPacket;
+      if (r.allocationFree && r.allocationsPerPacket > 0)
+        {
+          status = 1;
+          std::cout << "  ❌ allocates";
+        }
+      std::cout << "\n";
+    }
+  if (status == 0)
+    {
+      std::cout << "\n✅ Per-packet collection is allocation-free\n";
+    }
+  return status;
+}
+
+// Runs every station count at every duration. Exit status 1 when a case fails
+// or its events/s fall more than 'tolerance' below the baseline.
+inline int BenchmarkMain (int argc, char *argv[])
+{
+  bool distributed = EnableDistributed (&argc, &argv);
+  std::string profile = "metrics";
+  std::string serverTier;
+  std::string channelPlan;
+  std::string stationList = "1,4,16,64,256";
+  std::string durationList = "10,60,600";
+  std::string fidelityList = "default";
+  std::string output = "surgical_benchmark.csv";
+  std::string baselineFile;
+  double tolerance = 0.10;
+  bool updateBaseline = false;
+  uint32_t collectorPackets = 0;
+  uint32_t collectorFlows = 64;
+
+  CommandLine cmd;
+  cmd.AddValue ("profile", "Scenario profile the cases start from: metrics or surgical", profile);
+  cmd.AddValue ("serverTier", "Override the profile's server tier: edge, fog or cloud", serverTier);
+  cmd.AddValue ("channelPlan", "Override the profile's channel plan: shared or orthogonal", channelPlan);
+  cmd.AddValue ("distributed", "Run the cases under MPI (mpirun -np N) and report the speedup", distributed);
+  cmd.AddValue ("stations", "Comma-separated station counts", stationList);
+  cmd.AddValue ("durations", "Comma-separated simulated durations (s)", durationList);
+  cmd.AddValue ("fidelities", "Comma-separated Wi-Fi fidelities to run each case at: fast, default, high", fidelityList);
+  cmd.AddValue ("output", "Benchmark results CSV", output);
+  cmd.AddValue ("baseline", "Baseline CSV (an earlier --output) to compare events/s against", baselineFile);
+  cmd.AddValue ("tolerance", "Allowed relative events/s drop below the baseline", tolerance);
+  cmd.AddValue ("updateBaseline", "Write the results to --baseline instead of comparing", updateBaseline);
+  cmd.AddValue ("collectorPackets", "Time the collector's per-packet path over this many packets instead (0 = off)", collectorPackets);
+  cmd.AddValue ("collectorFlows", "With --collectorPackets, flows the packets are spread over", collectorFlows);
+  cmd.Parse (argc, argv);
+
+  if (collectorPackets > 0)
+    {
+      int status = RunCollectorBenchmark (collectorPackets, collectorFlows);
+      DisableDistributed (distributed);
+      return status;
+    }
+
+  ScenarioConfig base;
+  ApplyProfile (base, profile);
+  if (!serverTier.empty ())
+    base.serverTier = serverTier;
+  if (!channelPlan.empty ())
+    base.channelPlan = channelPlan;
+  base.distributed = distributed;
+  std::vector<uint32_t> stations = ParseBenchmarkList<uint32_t> (stationList, "stations");
+  std::vector<double> durations = ParseBenchmarkList<double> (durationList, "durations");
+  std::vector<std::string> fidelities;
+  std::istringstream fidelityTokens (fidelityList);
+  std::string fidelity;
+  while (std::getline (fidelityTokens, fidelity, ','))
+    {
+      NS_ABORT_MSG_IF (fidelity != "fast" && fidelity != "default" && fidelity != "high",
+                       "unknown fidelity '" << fidelity << "' in --fidelities");
+      fidelities.push_back (fidelity);
+    }
+  NS_ABORT_MSG_IF (fidelities.empty (), "--fidelities lists no values");
+  NS_ABORT_MSG_IF (updateBaseline && baselineFile.empty (), "--updateBaseline needs --baseline=<file>");
+  NS_ABORT_MSG_IF (distributed && updateBaseline, "record the baseline with a sequential run");
+  auto baseline = LoadBenchmarkBaseline (updateBaseline ? "" : baselineFile);
+
+  // Every rank runs the cases; only rank 0 reports them
+  bool root = DistributedRank () == 0;
+  std::streambuf* coutBuf = std::cout.rdbuf ();
+  std::ofstream discard;
+  if (!root)
+    {
+      std::cout.rdbuf (discard.rdbuf ());
+    }
+
+  std::cout << "🏁 Benchmark: " << stations.size () * durations.size () * fidelities.size ()
+            << " cases, profile " << profile
+            << ", RngSeed " << g_benchmarkSeed << " RngRun " << g_benchmarkRngRun;
+  if (distributed)
+    std::cout << ", " << DistributedSize () << " MPI ranks";
+  std::cout << "\n\n";
+  std::cout << std::right << std::setw(9) << "Stations" << std::setw(9) << "Sim s" << std::setw(9) << "Fidelity"
+            << std::setw(11) << "Wall s" << std::setw(13) << "Events" << std::setw(12) << "Events/s"
+            << std::setw(10) << "RSS MB" << std::setw(10) << "Lat err"
+            << std::setw(12) << (distributed ? "Speedup" : "vs base") << "\n";
+
+  std::vector<BenchmarkResult> results;
+  uint32_t failed = 0;
+  uint32_t regressed = 0;
+  for (double duration : durations)
+    {
+      for (uint32_t n : stations)
+        {
+          // All fidelities of one case first: the high one is the latency reference
+          std::vector<BenchmarkResult> caseResults;
+          for (const auto& f : fidelities)
+            {
+              caseResults.push_back (RunBenchmarkCase (base, {n, duration, f}, output));
+            }
+          auto reference = std::find_if (caseResults.begin (), caseResults.end (), [] (const BenchmarkResult& r) {
+            return r.done && r.bench.fidelity == "high";
+          });
+          for (auto& r : caseResults)
+            {
+              if (r.done && reference != caseResults.end () && reference->meanLatencyMs > 0)
+                {
+                  r.latencyErrorPercent = (r.meanLatencyMs / reference->meanLatencyMs - 1.0) * 100.0;
+                }
+            }
+
+          for (const auto& r : caseResults)
+            {
+              results.push_back (r);
+              std::cout << std::setw(9) << n << std::setw(9) << std::fixed << std::setprecision (0) << duration
+                        << std::setw(9) << r.bench.fidelity;
+              if (!r.done)
+                {
+                  ++failed;
+                  std::cout << "   ❌ case failed\n";
+                  continue;
+                }
+              std::cout << std::setw(11) << std::setprecision (2) << r.wallSeconds
+                        << std::setw(13) << r.events
+                        << std::setw(12) << std::setprecision (0) << EventsPerSecond (r)
+                        << std::setw(10) << std::setprecision (1) << r.peakRssMb;
+              if (std::isnan (r.latencyErrorPercent))
+                {
+                  std::cout << std::setw(10) << "-";
+                }
+              else
+                {
+                  std::cout << std::setw(8) << std::showpos << std::setprecision (1) << r.latencyErrorPercent
+                            << std::noshowpos << " %";
+                }
+
+              auto b = baseline.find (std::make_tuple (n, duration, r.bench.fidelity));
+              if (b == baseline.end ())
+                {
+                  std::cout << std::setw(12) << "-" << "\n";
+                  continue;
+                }
+              if (distributed)
+                {
+                  std::cout << std::setw(11) << std::setprecision (2)
+                            << b->second.wallSeconds / r.wallSeconds << "x\n";
+                  continue;
+                }
+              double change = EventsPerSecond (r) / EventsPerSecond (b->second) - 1.0;
+              std::cout << std::setw(10) << std::showpos << std::setprecision (1) << change * 100.0
+                        << std::noshowpos << " %";
+              if (change < -tolerance)
+                {
+                  ++regressed;
+                  std::cout << "  ❌ regression";
+                }
+              if (r.events != b->second.events)
+                {
+                  // Same seeds, different event count: the model changed, so
+                  // the throughput comparison is only indicative
+                  std::cout << "  ⚠️  " << std::showpos
+                            << static_cast<int64_t> (r.events) - static_cast<int64_t> (b->second.events)
+                            << std::noshowpos << " events";
+                }
+              std::cout << "\n";
+            }
+        }
+    }
+
+  if (!root)
+    {
+      std::cout.rdbuf (coutBuf);
+      DisableDistributed (distributed);
+      return 0;
+    }
+  ExportBenchmarkToCSV (results, output);
+  std::cout << "\n📊 Benchmark CSV exported: " << output << "\n";
+  if (updateBaseline)
+    {
+      ExportBenchmarkToCSV (results, baselineFile);
+      std::cout << "📌 Baseline updated: " << baselineFile << "\n";
+    }
+  if (failed > 0 || regressed > 0)
+    {
+      std::cout << "❌ " << failed << " cases failed, " << regressed << " regressed more than "
+                << std::setprecision (0) << tolerance * 100.0 << " % in events/s\n";
+      DisableDistributed (distributed);
+      return 1;
+    }
+  std::cout << "✅ No throughput regression" << (baseline.empty () ? " (no baseline compared)" : "") << "\n";
+  DisableDistributed (distributed);
+  return 0;
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_BENCHMARK_H */
@@ -0,0 +1,410 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Result rows and a content-addressed cache of scenario results
+ */
+
+#ifndef SURGICAL_CACHE_H
+#define SURGICAL_CACHE_H
+
+#include "surgical-scenario.h"
+
+namespace ns3 {
+
+// ===== Result rows =====
+// A ScenarioResult as comma-separated text rows: one "D" row per device,
+// one "P" row per position cell, then the "R" row with the simulator cost,
+// watchdog outcome and real-time lag. Field 1 is the run index. Sweep
+// workers stream these rows to the parent and the result cache stores them.
+
+inline std::vector<std::string> ResultRows (uint32_t run, const ScenarioResult& result)
+{
+  std::vector<std::string> rows;
+  for (const auto& r : result.devices)
+    {
+      std::ostringstream row;
+      row << std::setprecision (std::numeric_limits<double>::max_digits10);
+      row << "D," << run << "," << r.name << "," << r.txPackets << "," << r.rxPackets << ","
+          << r.lossRate << "," << r.avgLatencyMs << "," << r.avgJitterMs << ","
+          << r.taskCompletionTime << "," << r.taskCompleted << ","
+          << r.deviceClass << "," << r.room << "," << r.latency.Serialize () << ","
+          << r.direction << "," << r.energyJ << "," << r.batteryLifeHours;
+      rows.push_back (row.str ());
+    }
+  for (const auto& p : result.positions)
+    {
+      std::ostringstream row;
+      row << std::setprecision (std::numeric_limits<double>::max_digits10);
+      row << "P," << run << "," << p.name << "," << p.direction << "," << p.cellX << "," << p.cellY << ","
+          << p.latency.Serialize ();
+      rows.push_back (row.str ());
+    }
+  std::ostringstream row;
+  row << std::setprecision (std::numeric_limits<double>::max_digits10);
+  row << "R," << run << "," << result.stations << "," << result.events << ","
+      << result.wallSeconds << "," << result.peakRssMb << "," << result.simulatedSeconds << ","
+      << result.backgroundMbps << "," << result.safety.stopped << "," << result.safety.time.GetSeconds () << ","
+      << result.safety.device << "," << result.safety.cause << ","
+      << result.realtime.enabled << "," << result.realtime.probes << ","
+      << result.realtime.lag.Serialize () << "," << result.realtime.jitterMs << ","
+      << result.realtime.late << "," << result.realtime.budgetMs << ","
+      << result.associations << "," << result.lastAssociationSeconds << "," << result.cached;
+  rows.push_back (row.str ());
+  return rows;
+}
+
+inline std::vector<std::string> SplitResultRow (const std::string& line)
+{
+  std::istringstream row (line);
+  std::string field;
+  std::vector<std::string> f;
+  while (std::getline (row, field, ','))
+    {
+      f.push_back (field);
+    }
+  return f;
+}
+
+// Add one split row to 'result'; returns true for the closing "R" row.
+// Rows of another shape are ignored.
+inline bool ApplyResultRow (const std::vector<std::string>& f, ScenarioResult& result)
+{
+  if (f.size () == 21 && f[0] == "R")
+    {
+      result.stations = std::stoul (f[2]);
+      result.events = std::stoull (f[3]);
+      result.wallSeconds = std::stod (f[4]);
+      result.peakRssMb = std::stod (f[5]);
+      result.simulatedSeconds = std::stod (f[6]);
+      result.backgroundMbps = std::stod (f[7]);
+      result.safety.stopped = (f[8] == "1");
+      result.safety.time = Seconds (std::stod (f[9]));
+      result.safety.device = f[10];
+      result.safety.cause = f[11];
+      result.realtime.enabled = (f[12] == "1");
+      result.realtime.probes = std::stoull (f[13]);
+      result.realtime.lag = LatencyHistogram::Deserialize (f[14]);
+      result.realtime.jitterMs = std::stod (f[15]);
+      result.realtime.late = std::stoull (f[16]);
+      result.realtime.budgetMs = std::stod (f[17]);
+      result.associations = std::stoul (f[18]);
+      result.lastAssociationSeconds = std::stod (f[19]);
+      result.cached = (f[20] == "1");
+      return true;
+    }
+  if (f.size () == 16 && f[0] == "D")
+    {
+      DeviceMetrics m;
+      m.name = f[2];
+      m.txPackets = std::stoul (f[3]);
+      m.rxPackets = std::stoul (f[4]);
+      m.lossRate = std::stod (f[5]);
+      m.avgLatencyMs = std::stod (f[6]);
+      m.avgJitterMs = std::stod (f[7]);
+      m.taskCompletionTime = std::stod (f[8]);
+      m.taskCompleted = (f[9] == "1");
+      m.deviceClass = static_cast<DeviceClass> (std::stoul (f[10]));
+      m.room = std::stoul (f[11]);
+      m.latency = LatencyHistogram::Deserialize (f[12]);
+      m.direction = static_cast<FlowDirection> (std::stoul (f[13]));
+      m.energyJ = std::stod (f[14]);
+      m.batteryLifeHours = std::stod (f[15]);
+      result.devices.push_back (m);
+    }
+  else if (f.size () == 7 && f[0] == "P")
+    {
+      result.positions.push_back ({f[2], static_cast<FlowDirection> (std::stoul (f[3])),
+                                   std::stod (f[4]), std::stod (f[5]),
+                                   LatencyHistogram::Deserialize (f[6])});
+    }
+  return false;
+}
+
+// ===== Content-addressed result cache =====
+// With resultCache set, a run whose scenario was simulated before (same
+// parameters, seed and program binary) returns the stored result instead of
+// simulating. The key is the 64-bit FNV-1a hash of the build stamp followed
+// by DescribeScenario (); <resultCache>/<key>.rows holds that description
+// as "#" lines, checked on lookup so a hash collision is a miss, then the
+// result rows. The simulator cost in a cached result is that of the run
+// that stored it.
+
+inline uint64_t Fnv1a (const std::string& data, uint64_t hash = 14695981039346656037ULL)
+{
+  for (unsigned char c : data)
+    {
+      hash = (hash ^ c) * 1099511628211ULL;
+    }
+  return hash;
+}
+
+inline std::string HexKey (uint64_t hash)
+{
+  std::ostringstream out;
+  out << std::hex << std::setw (16) << std::setfill ('0') << hash;
+  return out.str ();
+}
+
+inline std::string FileHash (const std::string& path)
+{
+  std::ifstream in (path, std::ios::binary);
+  if (!in)
+    {
+      return "missing";
+    }
+  std::ostringstream contents;
+  contents << in.rdbuf ();
+  return HexKey (Fnv1a (contents.str ()));
+}
+
+// Hash of the running program: the model is header-only and compiled into
+// it, so any change to the model or its build gives a new stamp. Shared
+// ns-3 libraries are not covered; clear the cache after upgrading ns-3.
+inline const std::string& BuildStamp ()
+{
+  static const std::string stamp = FileHash ("/proc/self/exe");
+  return stamp;
+}
+
+// Runs whose outputs go beyond ScenarioResult (packet tables, traces,
+// windows, NetAnim, profiles), depend on the wall clock or run under MPI
+// are always simulated
+inline bool IsCacheable (const ScenarioConfig& cfg)
+{
+  return !cfg.resultCache.empty () && !WantsBinary (cfg) && !cfg.enableNetAnim && !cfg.packetTrace
+         && !cfg.windowInterval.IsStrictlyPositive () && !cfg.profiling && !cfg.realtime && !cfg.distributed;
+}
+
+// Every parameter the result of a cacheable run depends on, one key=value
+// per line; new ScenarioConfig fields that affect the model must be added
+// here, followed by the ns-3 attribute overrides. Output settings
+// (outputFormat, runId, NetAnim, traces, windows) and the features
+// IsCacheable rules out are left out.
+inline std::string DescribeScenario (const ScenarioConfig& cfg)
+{
+  std::ostringstream d;
+  d << std::setprecision (std::numeric_limits<double>::max_digits10);
+  auto time = [] (Time t) { return t.GetTimeStep (); };
+  d << "simulationTime=" << cfg.simulationTime << "\n"
+    << "rngSeed=" << RngSeedManager::GetSeed () << "\n"
+    << "rngRun=" << cfg.rngRun << "\n"
+    << "warmStart=" << cfg.warmStart << "\n"
+    << "warmStartSettle=" << time (cfg.warmStartSettle) << "\n"
+    << "safetyLatencyMs=" << cfg.safetyLatencyMs << "\n"
+    << "safetyTaskSec=" << cfg.safetyTaskSec << "\n"
+    << "safetyStop=" << cfg.safetyStop << "\n"
+    << "safetyCheckInterval=" << time (cfg.safetyCheckInterval) << "\n"
+    << "rooms=" << cfg.rooms << "\n"
+    << "robotsPerRoom=" << cfg.robotsPerRoom << "\n"
+    << "endoscopesPerRoom=" << cfg.endoscopesPerRoom << "\n"
+    << "vitalsPerRoom=" << cfg.vitalsPerRoom << "\n"
+    << "roomSpacing=" << cfg.roomSpacing << "\n"
+    << "mobility=" << cfg.mobility << "\n"
+    << "mobileClasses=" << cfg.mobileClasses << "\n"
+    << "trajectoryFile=" << cfg.trajectoryFile << " "
+    << (cfg.trajectoryFile.empty () ? std::string ("-") : FileHash (cfg.trajectoryFile)) << "\n"
+    << "mobilitySpeed=" << cfg.mobilitySpeed << "\n"
+    << "mobilityPause=" << time (cfg.mobilityPause) << "\n"
+    << "obstaclesPerRoom=" << cfg.obstaclesPerRoom << "\n"
+    << "obstacleLossDb=" << cfg.obstacleLossDb << "\n"
+    << "obstacleRadius=" << cfg.obstacleRadius << "\n"
+    << "mobilityUpdateInterval=" << time (cfg.mobilityUpdateInterval) << "\n"
+    << "positionCell=" << cfg.positionCell << "\n"
+    << "ssid=" << cfg.ssid << "\n"
+    << "channelPlan=" << cfg.channelPlan << "\n"
+    << "neighbourBss=" << cfg.neighbourBss << "\n"
+    << "backgroundStations=" << cfg.backgroundStations << "\n"
+    << "backgroundTraffic=" << cfg.backgroundTraffic << "\n"
+    << "backgroundRateMbps=" << cfg.backgroundRateMbps << "\n"
+    << "backgroundPacketSize=" << cfg.backgroundPacketSize << "\n"
+    << "backgroundStart=" << time (cfg.backgroundStart) << "\n"
+    << "neighbourDistance=" << cfg.neighbourDistance << "\n"
+    << "bssColoring=" << cfg.bssColoring << "\n"
+    << "obssPdLevel=" << cfg.obssPdLevel << "\n"
+    << "serverTier=" << cfg.serverTier << "\n"
+    << "fogLinkRate=" << cfg.fogLinkRate << "\n"
+    << "fogLinkDelay=" << time (cfg.fogLinkDelay) << "\n"
+    << "cloudLinkRate=" << cfg.cloudLinkRate << "\n"
+    << "cloudLinkDelay=" << time (cfg.cloudLinkDelay) << "\n"
+    << "cloudLinkLossPercent=" << cfg.cloudLinkLossPercent << "\n"
+    << "qos=" << cfg.qos << "\n"
+    << "txPowerDbm=" << cfg.txPowerDbm << "\n"
+    << "dataMode=" << cfg.dataMode << "\n"
+    << "fidelity=" << cfg.fidelity << "\n"
+    << "rateControl=" << cfg.rateControl << "\n"
+    << "fastRange=" << cfg.fastRange << "\n"
+    << "wallLossDb=" << cfg.wallLossDb << "\n"
+    << "batteryClasses=" << cfg.batteryClasses << "\n"
+    << "batteryEnergyJ=" << cfg.batteryEnergyJ << "\n"
+    << "batteryVoltage=" << cfg.batteryVoltage << "\n"
+    << "powerSave=" << cfg.powerSave << "\n"
+    << "twtInterval=" << time (cfg.twtInterval) << "\n"
+    << "twtWakeDuration=" << time (cfg.twtWakeDuration) << "\n"
+    << "trafficModel=" << cfg.trafficModel << "\n"
+    << "robotTraffic=" << cfg.robotTraffic << "\n"
+    << "robotStart=" << time (cfg.robotStart) << "\n"
+    << "robotDownlink=" << cfg.robotDownlink << "\n"
+    << "robotMaxPackets=" << cfg.robotMaxPackets << "\n"
+    << "robotInterval=" << time (cfg.robotInterval) << "\n"
+    << "robotPacketSize=" << cfg.robotPacketSize << "\n"
+    << "robotPort=" << cfg.robotPort << "\n"
+    << "videoTraffic=" << cfg.videoTraffic << "\n"
+    << "videoStart=" << time (cfg.videoStart) << "\n"
+    << "videoDownlink=" << cfg.videoDownlink << "\n"
+    << "videoMaxPackets=" << cfg.videoMaxPackets << "\n"
+    << "videoInterval=" << time (cfg.videoInterval) << "\n"
+    << "videoPacketSize=" << cfg.videoPacketSize << "\n"
+    << "videoPort=" << cfg.videoPort << "\n"
+    << "videoBitrateMbps=" << cfg.videoBitrateMbps << "\n"
+    << "videoGopLength=" << cfg.videoGopLength << "\n"
+    << "videoIFrameRatio=" << cfg.videoIFrameRatio << "\n"
+    << "vitalTraffic=" << cfg.vitalTraffic << "\n"
+    << "vitalStart=" << time (cfg.vitalStart) << "\n"
+    << "vitalDownlink=" << cfg.vitalDownlink << "\n"
+    << "vitalMaxPackets=" << cfg.vitalMaxPackets << "\n"
+    << "vitalInterval=" << time (cfg.vitalInterval) << "\n"
+    << "vitalPacketSize=" << cfg.vitalPacketSize << "\n"
+    << "vitalPort=" << cfg.vitalPort << "\n";
+  for (const auto& setting : cfg.attributeOverrides)
+    {
+      d << "override=" << setting << "\n";
+    }
+  return d.str ();
+}
+
+// The ns-3 attribute defaults and global values set on the command line
+// (--ns3::WifiMacQueue::MaxDelay=..., --WifiMacQueue::MaxDelay=...,
+// --ChecksumEnabled=1), sorted so that their order does not matter.
+// RngSeed and RngRun are left out: DescribeScenario has them already.
+inline std::vector<std::string> AttributeOverrides (int argc, char *argv[])
+{
+  std::set<std::string> globals;
+  for (auto i = GlobalValue::Begin (); i != GlobalValue::End (); ++i)
+    {
+      if ((*i)->GetName () != "RngSeed" && (*i)->GetName () != "RngRun")
+        {
+          globals.insert ((*i)->GetName ());
+        }
+    }
+  std::vector<std::string> overrides;
+  for (int i = 1; i < argc; ++i)
+    {
+      std::string arg = argv[i];
+      if (arg.compare (0, 2, "--") != 0)
+        {
+          continue;
+        }
+      std::string name = arg.substr (2, arg.find ('=') - 2);
+      if (name.find ("::") != std::string::npos || globals.count (name) > 0)
+        {
+          overrides.push_back (arg.substr (2));
+        }
+    }
+  std::sort (overrides.begin (), overrides.end ());
+  return overrides;
+}
+
+// The header of a cache file: build stamp and scenario description
+inline std::string CacheHeader (const ScenarioConfig& cfg)
+{
+  std::string header = "# build=" + BuildStamp () + "\n";
+  std::istringstream description (DescribeScenario (cfg));
+  std::string line;
+  while (std::getline (description, line))
+    {
+      header += "# " + line + "\n";
+    }
+  return header;
+}
+
+inline std::string ResultCachePath (const ScenarioConfig& cfg)
+{
+  return cfg.resultCache + "/" + HexKey (Fnv1a (CacheHeader (cfg))) + ".rows";
+}
+
+// Fill 'result' from the cache; false on a miss or an unreadable entry
+inline bool LoadCachedResult (const ScenarioConfig& cfg, ScenarioResult& result)
+{
+  std::ifstream in (ResultCachePath (cfg));
+  if (!in)
+    {
+      return false;
+    }
+  const std::string header = CacheHeader (cfg);
+  std::string stored, line;
+  while (in.peek () == '#' && std::getline (in, line))
+    {
+      stored += line + "\n";
+    }
+  if (stored != header)
+    {
+      NS_LOG_WARN ("Result cache: " << ResultCachePath (cfg) << " holds another scenario; simulating");
+      return false;
+    }
+  ScenarioResult cached;
+  try
+    {
+      while (std::getline (in, line))
+        {
+          if (ApplyResultRow (SplitResultRow (line), cached))
+            {
+              cached.cached = true;
+              result = cached;
+              return true;
+            }
+        }
+    }
+  catch (const std::exception&)
+    {
+    }
+  NS_LOG_WARN ("Result cache: " << ResultCachePath (cfg) << " is truncated or corrupt; simulating");
+  return false;
+}
+
+// Write through a temporary file and rename it, so concurrent sweep workers
+// storing the same scenario never leave a half-written entry
+inline void StoreCachedResult (const ScenarioConfig& cfg, const ScenarioResult& result)
+{
+  MakeDirectories (cfg.resultCache);
+  const std::string path = ResultCachePath (cfg);
+  const std::string temporary = path + ".tmp" + std::to_string (getpid ());
+  {
+    std::ofstream out (temporary);
+    if (!out.is_open ())
+      {
+        NS_LOG_WARN ("Result cache: cannot write " << temporary);
+        return;
+      }
+    out << CacheHeader (cfg);
+    for (const auto& row : ResultRows (0, result))
+      {
+        out << row << "\n";
+      }
+  }
+  if (std::rename (temporary.c_str (), path.c_str ()) != 0)
+    {
+      NS_LOG_WARN ("Result cache: cannot rename " << temporary << " to " << path);
+      std::remove (temporary.c_str ());
+    }
+}
+
+// RunScenario through the cache: a hit returns the stored result, a miss
+// simulates and stores it
+inline ScenarioResult RunCachedScenario (const ScenarioConfig& cfg, BinaryResults* binary = nullptr)
+{
+  if (!IsCacheable (cfg))
+    {
+      return RunScenario (cfg, binary);
+    }
+  ScenarioResult result;
+  if (LoadCachedResult (cfg, result))
+    {
+      return result;
+    }
+  result = RunScenario (cfg, binary);
+  StoreCachedResult (cfg, result);
+  return result;
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_CACHE_H */
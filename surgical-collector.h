@@ -0,0 +1,719 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Streaming per-flow latency collector and time-windowed sampler
+ */
+
+#ifndef SURGICAL_COLLECTOR_H
+#define SURGICAL_COLLECTOR_H
+
+#include "surgical-histogram.h"
+#include "surgical-columnar.h"
+#include "surgical-trace.h"
+
+namespace ns3 {
+
+// ===== Streaming latency collector =====
+// Client Tx trace stamps each packet with its flow index, sequence number
+// and send time; the echo server's Rx trace reads the stamp and folds the
+// one-way delay into fixed-size running totals, so memory per flow does not
+// grow with run length.
+// The one-way surgical sources (surgical-traffic.h) carry the same fields in
+// a SurgicalHeader instead, read at the PacketSink.
+//
+// The per-packet path allocates nothing and does no string work: devices
+// are dense flow indices fixed at setup, echo stamps live in a preallocated
+// SendStampPool rather than in packet tags, and every per-flow total is a
+// fixed-size slot (surgical-iomt-bench --collectorPackets measures it).
+
+class SurgicalTimestampTag : public Tag
+{
+public:
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const override;
+  uint32_t GetSerializedSize () const override;
+  void Serialize (TagBuffer i) const override;
+  void Deserialize (TagBuffer i) override;
+  void Print (std::ostream& os) const override;
+
+  uint32_t m_flow = 0;
+  uint32_t m_seq = 0;
+  Time m_txTime;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (SurgicalTimestampTag);
+
+inline TypeId SurgicalTimestampTag::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::SurgicalTimestampTag")
+    .SetParent<Tag> ()
+    .AddConstructor<SurgicalTimestampTag> ();
+  return tid;
+}
+
+inline TypeId SurgicalTimestampTag::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+inline uint32_t SurgicalTimestampTag::GetSerializedSize () const
+{
+  return 2 * sizeof (uint32_t) + sizeof (int64_t);
+}
+
+inline void SurgicalTimestampTag::Serialize (TagBuffer i) const
+{
+  i.WriteU32 (m_flow);
+  i.WriteU32 (m_seq);
+  i.WriteU64 (static_cast<uint64_t> (m_txTime.GetTimeStep ()));
+}
+
+inline void SurgicalTimestampTag::Deserialize (TagBuffer i)
+{
+  m_flow = i.ReadU32 ();
+  m_seq = i.ReadU32 ();
+  m_txTime = TimeStep (static_cast<int64_t> (i.ReadU64 ()));
+}
+
+inline void SurgicalTimestampTag::Print (std::ostream& os) const
+{
+  os << "flow=" << m_flow << " seq=" << m_seq << " tx=" << m_txTime;
+}
+
+// Payload header of the surgical traffic sources: flow index, per-flow
+// sequence number and send time, 16 bytes on the wire
+class SurgicalHeader : public Header
+{
+public:
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const override;
+  uint32_t GetSerializedSize () const override;
+  void Serialize (Buffer::Iterator start) const override;
+  uint32_t Deserialize (Buffer::Iterator start) override;
+  void Print (std::ostream& os) const override;
+
+  uint32_t m_flow = 0;
+  uint32_t m_seq = 0;
+  Time m_txTime;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (SurgicalHeader);
+
+inline TypeId SurgicalHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::SurgicalHeader")
+    .SetParent<Header> ()
+    .AddConstructor<SurgicalHeader> ();
+  return tid;
+}
+
+inline TypeId SurgicalHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+inline uint32_t SurgicalHeader::GetSerializedSize () const
+{
+  return 2 * sizeof (uint32_t) + sizeof (int64_t);
+}
+
+inline void SurgicalHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteHtonU32 (m_flow);
+  start.WriteHtonU32 (m_seq);
+  start.WriteHtonU64 (static_cast<uint64_t> (m_txTime.GetNanoSeconds ()));
+}
+
+inline uint32_t SurgicalHeader::Deserialize (Buffer::Iterator start)
+{
+  m_flow = start.ReadNtohU32 ();
+  m_seq = start.ReadNtohU32 ();
+  m_txTime = NanoSeconds (static_cast<int64_t> (start.ReadNtohU64 ()));
+  return GetSerializedSize ();
+}
+
+inline void SurgicalHeader::Print (std::ostream& os) const
+{
+  os << "flow=" << m_flow << " seq=" << m_seq << " tx=" << m_txTime;
+}
+
+// Echo stamps without packet tags: AddPacketTag allocates a tag node for
+// every packet sent, so sequential runs file the stamp in a fixed pool slot
+// picked by the packet's uid instead. The uid survives every copy ns-3 makes
+// of the packet on its way to the server. A slot is reused once the uid
+// space has wrapped around the pool, so a stamp can only be lost when two
+// echo packets whose uids differ by a multiple of the pool size are in
+// flight at once; that is counted, and the packet counts as lost. Stamps
+// over a second old are not counted: Wi-Fi MAC queues drop frames after
+// 500 ms, so those belong to packets that were lost anyway. Packets
+// serialized between MPI ranks keep their tags but not their uid, so
+// distributed runs stamp with SurgicalTimestampTag.
+class SendStampPool
+{
+public:
+  // 'slots' is rounded up to a power of two
+  explicit SendStampPool (uint32_t slots);
+
+  void Put (uint64_t uid, uint32_t flow, uint32_t seq, Time txTime);
+  // The stamp of packet 'uid', once; false if it has none
+  bool Take (uint64_t uid, uint32_t& flow, uint32_t& seq, Time& txTime);
+  // Stamps under a second old overwritten before their packet arrived
+  uint64_t GetOverwritten () const;
+
+private:
+  struct Slot {
+    uint64_t uid = 0;  // uid + 1, 0 = free
+    uint32_t flow = 0;
+    uint32_t seq = 0;
+    int64_t txTimeStep = 0;
+  };
+
+  std::vector<Slot> m_slots;
+  uint64_t m_mask;
+  int64_t m_horizon;  // one second in time steps
+  uint64_t m_overwritten;
+};
+
+inline SendStampPool::SendStampPool (uint32_t slots)
+  : m_horizon (Seconds (1).GetTimeStep ()),
+    m_overwritten (0)
+{
+  uint64_t n = 1;
+  while (n < slots)
+    {
+      n <<= 1;
+    }
+  m_slots.resize (n);
+  m_mask = n - 1;
+}
+
+inline void SendStampPool::Put (uint64_t uid, uint32_t flow, uint32_t seq, Time txTime)
+{
+  Slot& s = m_slots[uid & m_mask];
+  if (s.uid != 0 && txTime.GetTimeStep () - s.txTimeStep < m_horizon)
+    {
+      ++m_overwritten;
+    }
+  s.uid = uid + 1;
+  s.flow = flow;
+  s.seq = seq;
+  s.txTimeStep = txTime.GetTimeStep ();
+}
+
+inline bool SendStampPool::Take (uint64_t uid, uint32_t& flow, uint32_t& seq, Time& txTime)
+{
+  Slot& s = m_slots[uid & m_mask];
+  if (s.uid != uid + 1)
+    {
+      return false;
+    }
+  flow = s.flow;
+  seq = s.seq;
+  txTime = TimeStep (s.txTimeStep);
+  s.uid = 0;
+  return true;
+}
+
+inline uint64_t SendStampPool::GetOverwritten () const
+{
+  return m_overwritten;
+}
+
+// Counters since the last window boundary, taken and reset by WindowedSampler
+struct FlowWindow {
+  uint32_t txPackets = 0;
+  uint32_t rxPackets = 0;
+  uint64_t txBytes = 0;
+  uint64_t rxBytes = 0;
+  int64_t delaySumNs = 0;
+  int64_t jitterSumNs = 0;
+  LatencyHistogram latency;
+};
+
+// Online per-flow totals, same semantics as FlowMonitor::FlowStats
+struct FlowAggregate {
+  uint32_t txPackets = 0;
+  uint32_t rxPackets = 0;
+  Time delaySum;
+  Time jitterSum;
+  Time lastDelay;
+  Time timeFirstTxPacket;
+  Time timeLastRxPacket;
+  LatencyHistogram latency;
+  FlowWindow window;
+};
+
+class LatencyCollector
+{
+public:
+  explicit LatencyCollector (uint32_t flows, uint32_t stampSlots = 65536);
+
+  // Count and stamp everything 'client' sends as flow 'flow'
+  void InstallClient (Ptr<Application> client, uint32_t flow);
+  // Measure every stamped packet 'server' receives
+  void InstallServer (Ptr<Application> server);
+  // Count what a surgical source sends; the flow comes from its SurgicalHeader
+  void InstallSource (Ptr<Application> source);
+  // Measure every SurgicalHeader packet a PacketSink receives
+  void InstallSink (Ptr<Application> sink);
+
+  const FlowAggregate& GetFlow (uint32_t flow) const;
+  uint32_t GetNFlows () const;
+  // Return the flow's window counters and start a new window
+  FlowWindow TakeWindow (uint32_t flow);
+  // Add totals of the same flow counted elsewhere (another MPI rank)
+  void MergeFlow (uint32_t flow, const FlowAggregate& other);
+
+  // Also append one row per received packet to 'packets' (may be null)
+  void SetPacketTable (ColumnarTable* packets, uint32_t rngRun);
+  // Also trace every packet sent and received to 'trace' (may be null)
+  void SetPacketTrace (PacketTraceWriter* trace);
+  // Also report (flow, delay) of every received packet to 'cb'
+  void SetRxCallback (Callback<void, uint32_t, Time> cb);
+  // Stamp echo packets with a packet tag instead of the stamp pool: needed
+  // when packets cross MPI ranks
+  void SetStampTags (bool tags);
+  const SendStampPool& GetStampPool () const;
+
+  // Trace sinks; public so the microbenchmark can drive them without a
+  // simulation
+  static void ClientTx (LatencyCollector* collector, uint32_t flow, Ptr<const Packet> packet);
+  void ServerRx (Ptr<const Packet> packet);
+  void SourceTx (Ptr<const Packet> packet);
+  void SinkRx (Ptr<const Packet> packet, const Address& from);
+
+private:
+  // Counts the packet and returns its sequence number within the flow
+  uint32_t CountTx (uint32_t flow, Time now, uint32_t size);
+  void RecordRx (uint32_t flow, uint32_t seq, Time txTime, uint32_t size);
+
+  std::vector<FlowAggregate> m_flows;
+  ColumnarTable* m_packets;
+  PacketTraceWriter* m_trace;
+  uint32_t m_rngRun;
+  Callback<void, uint32_t, Time> m_rxCallback;
+  SendStampPool m_stamps;
+  bool m_stampTags;
+};
+
+inline LatencyCollector::LatencyCollector (uint32_t flows, uint32_t stampSlots)
+  : m_flows (flows),
+    m_packets (nullptr),
+    m_trace (nullptr),
+    m_rngRun (0),
+    m_stamps (stampSlots),
+    m_stampTags (false)
+{
+}
+
+inline void LatencyCollector::SetStampTags (bool tags)
+{
+  m_stampTags = tags;
+}
+
+inline const SendStampPool& LatencyCollector::GetStampPool () const
+{
+  return m_stamps;
+}
+
+inline uint32_t LatencyCollector::GetNFlows () const
+{
+  return m_flows.size ();
+}
+
+inline FlowWindow LatencyCollector::TakeWindow (uint32_t flow)
+{
+  FlowWindow w = m_flows[flow].window;
+  m_flows[flow].window = FlowWindow ();
+  return w;
+}
+
+inline void LatencyCollector::SetPacketTable (ColumnarTable* packets, uint32_t rngRun)
+{
+  m_packets = packets;
+  m_rngRun = rngRun;
+}
+
+inline void LatencyCollector::SetPacketTrace (PacketTraceWriter* trace)
+{
+  m_trace = trace;
+}
+
+// Jitter is a sum over consecutive receptions; all of a flow's packets
+// arrive at one node, hence on one rank, so sums merge exactly
+inline void LatencyCollector::MergeFlow (uint32_t flow, const FlowAggregate& other)
+{
+  FlowAggregate& f = m_flows[flow];
+  if (other.txPackets > 0 && (f.txPackets == 0 || other.timeFirstTxPacket < f.timeFirstTxPacket))
+    {
+      f.timeFirstTxPacket = other.timeFirstTxPacket;
+    }
+  if (other.rxPackets > 0 && (f.rxPackets == 0 || other.timeLastRxPacket > f.timeLastRxPacket))
+    {
+      f.timeLastRxPacket = other.timeLastRxPacket;
+    }
+  f.txPackets += other.txPackets;
+  f.rxPackets += other.rxPackets;
+  f.delaySum += other.delaySum;
+  f.jitterSum += other.jitterSum;
+  f.latency.Merge (other.latency);
+}
+
+inline void LatencyCollector::SetRxCallback (Callback<void, uint32_t, Time> cb)
+{
+  m_rxCallback = cb;
+}
+
+inline void LatencyCollector::InstallClient (Ptr<Application> client, uint32_t flow)
+{
+  client->TraceConnectWithoutContext ("Tx", MakeBoundCallback (&LatencyCollector::ClientTx, this, flow));
+}
+
+inline void LatencyCollector::InstallServer (Ptr<Application> server)
+{
+  server->TraceConnectWithoutContext ("Rx", MakeCallback (&LatencyCollector::ServerRx, this));
+}
+
+inline void LatencyCollector::InstallSource (Ptr<Application> source)
+{
+  source->TraceConnectWithoutContext ("Tx", MakeCallback (&LatencyCollector::SourceTx, this));
+}
+
+inline void LatencyCollector::InstallSink (Ptr<Application> sink)
+{
+  sink->TraceConnectWithoutContext ("Rx", MakeCallback (&LatencyCollector::SinkRx, this));
+}
+
+inline const FlowAggregate& LatencyCollector::GetFlow (uint32_t flow) const
+{
+  return m_flows.at (flow);
+}
+
+inline uint32_t LatencyCollector::CountTx (uint32_t flow, Time now, uint32_t size)
+{
+  FlowAggregate& f = m_flows[flow];
+  uint32_t seq = f.txPackets++;
+  if (seq == 0)
+    {
+      f.timeFirstTxPacket = now;
+    }
+  ++f.window.txPackets;
+  f.window.txBytes += size;
+  if (m_trace)
+    {
+      m_trace->Append (flow, seq, size, now.GetNanoSeconds (), -1);
+    }
+  return seq;
+}
+
+inline void LatencyCollector::ClientTx (LatencyCollector* collector, uint32_t flow, Ptr<const Packet> packet)
+{
+  Time now = Simulator::Now ();
+  uint32_t seq = collector->CountTx (flow, now, packet->GetSize ());
+  if (!collector->m_stampTags)
+    {
+      collector->m_stamps.Put (packet->GetUid (), flow, seq, now);
+      return;
+    }
+  SurgicalTimestampTag tag;
+  tag.m_flow = flow;
+  tag.m_seq = seq;
+  tag.m_txTime = now;
+  packet->AddPacketTag (tag);
+}
+
+inline void LatencyCollector::SourceTx (Ptr<const Packet> packet)
+{
+  SurgicalHeader header;
+  packet->PeekHeader (header);
+  if (header.m_flow < m_flows.size ())
+    {
+      CountTx (header.m_flow, Simulator::Now (), packet->GetSize ());
+    }
+}
+
+inline void LatencyCollector::ServerRx (Ptr<const Packet> packet)
+{
+  uint32_t flow, seq;
+  Time txTime;
+  if (!m_stampTags)
+    {
+      if (m_stamps.Take (packet->GetUid (), flow, seq, txTime) && flow < m_flows.size ())
+        {
+          RecordRx (flow, seq, txTime, packet->GetSize ());
+        }
+      return;
+    }
+  SurgicalTimestampTag tag;
+  if (packet->PeekPacketTag (tag) && tag.m_flow < m_flows.size ())
+    {
+      RecordRx (tag.m_flow, tag.m_seq, tag.m_txTime, packet->GetSize ());
+    }
+}
+
+inline void LatencyCollector::SinkRx (Ptr<const Packet> packet, const Address& from)
+{
+  SurgicalHeader header;
+  if (packet->GetSize () >= header.GetSerializedSize ())
+    {
+      packet->PeekHeader (header);
+      if (header.m_flow < m_flows.size ())
+        {
+          RecordRx (header.m_flow, header.m_seq, header.m_txTime, packet->GetSize ());
+        }
+    }
+}
+
+inline void LatencyCollector::RecordRx (uint32_t flow, uint32_t seq, Time txTime, uint32_t size)
+{
+  Time now = Simulator::Now ();
+  Time delay = now - txTime;
+  FlowAggregate& f = m_flows[flow];
+  if (f.rxPackets > 0)
+    {
+      f.jitterSum += Abs (delay - f.lastDelay);
+      f.window.jitterSumNs += Abs (delay - f.lastDelay).GetNanoSeconds ();
+    }
+  f.delaySum += delay;
+  f.latency.Record (delay.GetNanoSeconds ());
+  f.lastDelay = delay;
+  f.timeLastRxPacket = now;
+  ++f.rxPackets;
+  ++f.window.rxPackets;
+  f.window.rxBytes += size;
+  f.window.delaySumNs += delay.GetNanoSeconds ();
+  f.window.latency.Record (delay.GetNanoSeconds ());
+
+  if (m_packets)
+    {
+      m_packets->Put<uint32_t> (PC_RUN, m_rngRun);
+      m_packets->Put<uint32_t> (PC_FLOW, flow);
+      m_packets->Put<int64_t> (PC_TX_TIME_NS, txTime.GetNanoSeconds ());
+      m_packets->Put<int64_t> (PC_RX_TIME_NS, now.GetNanoSeconds ());
+      m_packets->Put<uint32_t> (PC_SIZE, size);
+      m_packets->EndRow ();
+    }
+  if (m_trace)
+    {
+      m_trace->Append (flow, seq, size, txTime.GetNanoSeconds (), now.GetNanoSeconds ());
+    }
+  if (!m_rxCallback.IsNull ())
+    {
+      m_rxCallback (flow, delay);
+    }
+}
+
+// ===== Time-windowed sampler =====
+// A periodic event closes the current window of every flow and pushes one
+// sample per flow into a fixed-size ring; the ring is drained to the CSV
+// and/or binary windows table whenever it fills, so memory stays flat
+// however long the run is. Window loss is (tx - rx) / tx within the window,
+// so packets in flight across a boundary show up as a small +/- skew.
+
+struct WindowSample {
+  double startSec;
+  uint32_t flow;
+  uint32_t txPackets;
+  uint32_t rxPackets;
+  double lossRate;
+  double throughputKbps;
+  double p50LatencyMs;
+  double p99LatencyMs;
+  double maxLatencyMs;
+  // Not in the windows CSV or table; read live through GetLatest ()
+  double avgLatencyMs;
+  double avgJitterMs;
+  uint64_t txBytes;
+  uint64_t rxBytes;
+};
+
+class WindowedSampler
+{
+public:
+  // 'names' and 'directions' label each flow in the CSV (flows with an empty
+  // name are not sampled); 'csvPath' may be empty and 'table' null to skip
+  // that output
+  WindowedSampler (LatencyCollector& collector, const std::vector<std::string>& names,
+                   const std::vector<std::string>& directions, Time interval, uint32_t rngRun,
+                   const std::string& csvPath, ColumnarTable* table, uint32_t capacity = 4096);
+
+  void Start ();
+  // Sample the final partial window and drain the ring; call after Simulator::Run ()
+  void Finish ();
+
+  // Most recent closed window of 'flow', or null before the first one or
+  // for an unsampled flow
+  const WindowSample* GetLatest (uint32_t flow) const;
+  uint32_t GetNFlows () const;
+  const std::string& GetName (uint32_t flow) const;
+  const std::string& GetDirection (uint32_t flow) const;
+
+private:
+  void Tick ();
+  void SampleAll ();
+  void Push (const WindowSample& sample);
+  void Flush ();
+
+  LatencyCollector& m_collector;
+  std::vector<std::string> m_names;
+  std::vector<std::string> m_directions;
+  Time m_interval;
+  uint32_t m_rngRun;
+  ColumnarTable* m_table;
+  std::ofstream m_csv;
+
+  std::vector<WindowSample> m_latest;  // by flow
+  std::vector<bool> m_hasLatest;
+  std::vector<WindowSample> m_ring;
+  size_t m_head;
+  size_t m_size;
+  Time m_windowStart;
+};
+
+inline WindowedSampler::WindowedSampler (LatencyCollector& collector, const std::vector<std::string>& names,
+                                         const std::vector<std::string>& directions, Time interval, uint32_t rngRun,
+                                         const std::string& csvPath, ColumnarTable* table, uint32_t capacity)
+  : m_collector (collector),
+    m_names (names),
+    m_directions (directions),
+    m_interval (interval),
+    m_rngRun (rngRun),
+    m_table (table),
+    m_latest (names.size ()),
+    m_hasLatest (names.size (), false),
+    m_ring (capacity),
+    m_head (0),
+    m_size (0)
+{
+  if (!csvPath.empty ())
+    {
+      m_csv.open (csvPath);
+      if (!m_csv.is_open ())
+        {
+          NS_LOG_ERROR ("Failed to open " << csvPath << " for writing");
+        }
+      m_csv << std::fixed << std::setprecision (6);
+      m_csv << "Run,WindowStartSec,Device,TxPackets,RxPackets,LossPercent,ThroughputKbps,"
+            << "P50LatencyMs,P99LatencyMs,MaxLatencyMs,Direction\n";
+    }
+}
+
+inline void WindowedSampler::Start ()
+{
+  m_windowStart = Simulator::Now ();
+  Simulator::Schedule (m_interval, &WindowedSampler::Tick, this);
+}
+
+inline void WindowedSampler::Tick ()
+{
+  SampleAll ();
+  Simulator::Schedule (m_interval, &WindowedSampler::Tick, this);
+}
+
+inline void WindowedSampler::Finish ()
+{
+  if (Simulator::Now () > m_windowStart)
+    {
+      SampleAll ();
+    }
+  Flush ();
+}
+
+inline void WindowedSampler::SampleAll ()
+{
+  Time now = Simulator::Now ();
+  double lengthSec = (now - m_windowStart).GetSeconds ();
+  for (uint32_t flow = 0; flow < m_collector.GetNFlows (); ++flow)
+    {
+      FlowWindow w = m_collector.TakeWindow (flow);
+      if (m_names[flow].empty ())
+        {
+          continue;
+        }
+      Push ({
+        m_windowStart.GetSeconds (),
+        flow,
+        w.txPackets,
+        w.rxPackets,
+        (w.txPackets > 0) ? std::max (0.0, 1.0 - (double)w.rxPackets / w.txPackets) * 100.0 : 0.0,
+        (lengthSec > 0) ? w.rxBytes * 8.0 / lengthSec / 1000.0 : 0.0,
+        w.latency.GetQuantileMs (0.50),
+        w.latency.GetQuantileMs (0.99),
+        w.latency.GetMax () / 1e6,
+        (w.rxPackets > 0) ? (double)w.delaySumNs / w.rxPackets / 1e6 : 0.0,
+        (w.rxPackets > 0) ? (double)w.jitterSumNs / w.rxPackets / 1e6 : 0.0,
+        w.txBytes,
+        w.rxBytes
+      });
+    }
+  m_windowStart = now;
+}
+
+inline void WindowedSampler::Push (const WindowSample& sample)
+{
+  if (m_size == m_ring.size ())
+    {
+      Flush ();
+    }
+  m_ring[(m_head + m_size) % m_ring.size ()] = sample;
+  ++m_size;
+  m_latest[sample.flow] = sample;
+  m_hasLatest[sample.flow] = true;
+}
+
+inline const WindowSample* WindowedSampler::GetLatest (uint32_t flow) const
+{
+  return m_hasLatest[flow] ? &m_latest[flow] : nullptr;
+}
+
+inline uint32_t WindowedSampler::GetNFlows () const
+{
+  return m_names.size ();
+}
+
+inline const std::string& WindowedSampler::GetName (uint32_t flow) const
+{
+  return m_names[flow];
+}
+
+inline const std::string& WindowedSampler::GetDirection (uint32_t flow) const
+{
+  return m_directions[flow];
+}
+
+inline void WindowedSampler::Flush ()
+{
+  for (; m_size > 0; --m_size, m_head = (m_head + 1) % m_ring.size ())
+    {
+      const WindowSample& w = m_ring[m_head];
+      if (m_csv.is_open ())
+        {
+          m_csv << m_rngRun << "," << w.startSec << "," << m_names[w.flow] << ","
+                << w.txPackets << "," << w.rxPackets << "," << w.lossRate << ","
+                << w.throughputKbps << "," << w.p50LatencyMs << "," << w.p99LatencyMs << ","
+                << w.maxLatencyMs << "," << m_directions[w.flow] << "\n";
+        }
+      if (m_table)
+        {
+          m_table->Put<uint32_t> (WC_RUN, m_rngRun);
+          m_table->Put<double> (WC_WINDOW_START_S, w.startSec);
+          m_table->Put<uint32_t> (WC_FLOW, w.flow);
+          m_table->Put<uint32_t> (WC_TX_PACKETS, w.txPackets);
+          m_table->Put<uint32_t> (WC_RX_PACKETS, w.rxPackets);
+          m_table->Put<double> (WC_LOSS_PCT, w.lossRate);
+          m_table->Put<double> (WC_THROUGHPUT_KBPS, w.throughputKbps);
+          m_table->Put<double> (WC_P50_LATENCY_MS, w.p50LatencyMs);
+          m_table->Put<double> (WC_P99_LATENCY_MS, w.p99LatencyMs);
+          m_table->Put<double> (WC_MAX_LATENCY_MS, w.maxLatencyMs);
+          m_table->EndRow ();
+        }
+    }
+  m_head = 0;
+  if (m_csv.is_open ())
+    {
+      m_csv.flush ();
+    }
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_COLLECTOR_H */
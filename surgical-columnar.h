@@ -0,0 +1,289 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Append-only NumPy column tables for binary results
+ */
+
+#ifndef SURGICAL_COLUMNAR_H
+#define SURGICAL_COLUMNAR_H
+
+#include "surgical-common.h"
+
+namespace ns3 {
+
+// ===== Binary columnar results =====
+// Each table is a directory holding one NumPy .npy file per column, so
+// numpy.load (..., mmap_mode='r') maps a column straight into pandas (and
+// from there DuckDB) without parsing. Files are append-only: new rows go to
+// the end and only the fixed-size header is rewritten with the new row count,
+// so successive runs and sweeps extend the same files. Readers should trim
+// all columns of a table to the shortest one in case a writer was killed
+// mid-flush.
+
+inline void MakeDirectories (const std::string& path)
+{
+  for (size_t pos = path.find ('/', 1); ; pos = path.find ('/', pos + 1))
+    {
+      std::string prefix = path.substr (0, pos);
+      if (mkdir (prefix.c_str (), 0755) != 0 && errno != EEXIST)
+        {
+          NS_FATAL_ERROR ("Cannot create directory " << prefix);
+        }
+      if (pos == std::string::npos) break;
+    }
+}
+
+class ColumnarTable
+{
+public:
+  // 'descr' is the NumPy dtype string, e.g. "<u4", "<f8", "|S16"
+  struct Column {
+    std::string name;
+    std::string descr;
+    uint32_t width;
+  };
+
+  ColumnarTable (const std::string& dir, const std::vector<Column>& columns,
+                 uint32_t flushRows = 4096);
+  ~ColumnarTable ();
+
+  template <typename T>
+  void Put (uint32_t column, T value)
+  {
+    NS_ASSERT (sizeof (T) == m_columns[column].def.width);
+    PutBytes (column, &value);
+  }
+  // Zero-padded (or truncated) to the column width
+  void PutString (uint32_t column, const std::string& value);
+  // Completes a row; buffered rows are written every 'flushRows' rows
+  void EndRow ();
+  void Flush ();
+
+private:
+  static const uint32_t NPY_HEADER_SIZE = 128;
+
+  struct ColumnFile {
+    Column def;
+    std::string path;
+    uint64_t rows;
+    std::vector<char> buffer;
+  };
+
+  void PutBytes (uint32_t column, const void* data);
+  static void WriteHeader (std::ostream& out, const ColumnFile& c);
+  static uint64_t ReadRows (const ColumnFile& c);
+
+  std::vector<ColumnFile> m_columns;
+  uint32_t m_pendingRows;
+  uint32_t m_flushRows;
+};
+
+inline ColumnarTable::ColumnarTable (const std::string& dir, const std::vector<Column>& columns,
+                                     uint32_t flushRows)
+  : m_pendingRows (0),
+    m_flushRows (flushRows)
+{
+  MakeDirectories (dir);
+  for (const auto& def : columns)
+    {
+      ColumnFile c {def, dir + "/" + def.name + ".npy", 0, {}};
+      c.rows = ReadRows (c);
+      // Drop any tail left behind by an interrupted flush
+      if (truncate (c.path.c_str (), NPY_HEADER_SIZE + c.rows * def.width) != 0)
+        {
+          std::ofstream create (c.path, std::ios::binary);
+          WriteHeader (create, c);
+        }
+      c.buffer.reserve (static_cast<size_t> (def.width) * flushRows);
+      m_columns.push_back (c);
+    }
+}
+
+inline ColumnarTable::~ColumnarTable ()
+{
+  Flush ();
+}
+
+// Row count from an existing column file's header, 0 for a new file
+inline uint64_t ColumnarTable::ReadRows (const ColumnFile& c)
+{
+  std::ifstream in (c.path, std::ios::binary);
+  if (!in.is_open ())
+    {
+      return 0;
+    }
+  std::string header (NPY_HEADER_SIZE, '\0');
+  in.read (&header[0], NPY_HEADER_SIZE);
+  size_t shape = header.find ("'shape': (");
+  if (in.gcount () != NPY_HEADER_SIZE || header.compare (1, 5, "NUMPY") != 0
+      || header.find ("'descr': '" + c.def.descr + "'") == std::string::npos
+      || shape == std::string::npos)
+    {
+      NS_FATAL_ERROR (c.path << " exists but is not a " << c.def.descr << " column written by this tool");
+    }
+  return std::stoull (header.substr (shape + 10));
+}
+
+// NPY v1.0 header padded to a fixed NPY_HEADER_SIZE bytes so the row count
+// can be rewritten in place
+inline void ColumnarTable::WriteHeader (std::ostream& out, const ColumnFile& c)
+{
+  const uint16_t dictLen = NPY_HEADER_SIZE - 10;
+  std::string dict = "{'descr': '" + c.def.descr + "', 'fortran_order': False, 'shape': ("
+    + std::to_string (c.rows) + ",), }";
+  dict.resize (dictLen - 1, ' ');
+  dict += '\n';
+
+  out.seekp (0);
+  out.write ("\x93NUMPY\x01\x00", 8);
+  out.put (static_cast<char> (dictLen & 0xff));
+  out.put (static_cast<char> (dictLen >> 8));
+  out.write (dict.data (), dict.size ());
+}
+
+inline void ColumnarTable::PutBytes (uint32_t column, const void* data)
+{
+  const char* bytes = static_cast<const char*> (data);
+  ColumnFile& c = m_columns[column];
+  c.buffer.insert (c.buffer.end (), bytes, bytes + c.def.width);
+}
+
+inline void ColumnarTable::PutString (uint32_t column, const std::string& value)
+{
+  ColumnFile& c = m_columns[column];
+  size_t n = std::min<size_t> (value.size (), c.def.width);
+  c.buffer.insert (c.buffer.end (), value.begin (), value.begin () + n);
+  c.buffer.insert (c.buffer.end (), c.def.width - n, '\0');
+}
+
+inline void ColumnarTable::EndRow ()
+{
+  if (++m_pendingRows >= m_flushRows)
+    {
+      Flush ();
+    }
+}
+
+inline void ColumnarTable::Flush ()
+{
+  if (m_pendingRows == 0)
+    {
+      return;
+    }
+  for (auto& c : m_columns)
+    {
+      std::fstream out (c.path, std::ios::in | std::ios::out | std::ios::binary);
+      if (!out.is_open ())
+        {
+          NS_LOG_ERROR ("Failed to open " << c.path << " for appending");
+          continue;
+        }
+      out.seekp (NPY_HEADER_SIZE + c.rows * c.def.width);
+      out.write (c.buffer.data (), c.buffer.size ());
+      c.rows += m_pendingRows;
+      WriteHeader (out, c);
+      c.buffer.clear ();
+    }
+  m_pendingRows = 0;
+}
+
+enum DeviceColumn {
+  DC_RUN = 0,
+  DC_DEVICE,
+  DC_CLASS,
+  DC_ROOM,
+  DC_TX_PACKETS,
+  DC_RX_PACKETS,
+  DC_LOSS_PCT,
+  DC_AVG_LATENCY_MS,
+  DC_AVG_JITTER_MS,
+  DC_P50_LATENCY_MS,
+  DC_P99_LATENCY_MS,
+  DC_P999_LATENCY_MS,
+  DC_MAX_LATENCY_MS,
+  DC_TASK_TARGET,
+  DC_TASK_COMPLETED,
+  DC_TASK_TIME_S,
+  DC_DIRECTION,
+  DC_ENERGY_J,
+  DC_BATTERY_LIFE_H
+};
+
+enum WindowColumn {
+  WC_RUN = 0,
+  WC_WINDOW_START_S,
+  WC_FLOW,
+  WC_TX_PACKETS,
+  WC_RX_PACKETS,
+  WC_LOSS_PCT,
+  WC_THROUGHPUT_KBPS,
+  WC_P50_LATENCY_MS,
+  WC_P99_LATENCY_MS,
+  WC_MAX_LATENCY_MS
+};
+
+enum PacketColumn {
+  PC_RUN = 0,
+  PC_FLOW,
+  PC_TX_TIME_NS,
+  PC_RX_TIME_NS,
+  PC_SIZE
+};
+
+// Per-run device rows and per-packet rows of one writer process
+struct BinaryResults {
+  explicit BinaryResults (const std::string& dir);
+
+  std::string dir;
+  ColumnarTable devices;
+  ColumnarTable packets;
+  ColumnarTable windows;
+};
+
+inline BinaryResults::BinaryResults (const std::string& root)
+  : dir (root),
+    devices (root + "/devices", {
+      {"run", "<u4", 4},
+      {"device", "|S16", 16},
+      {"device_class", "|u1", 1},
+      {"room", "<u4", 4},
+      {"tx_packets", "<u4", 4},
+      {"rx_packets", "<u4", 4},
+      {"loss_pct", "<f8", 8},
+      {"avg_latency_ms", "<f8", 8},
+      {"avg_jitter_ms", "<f8", 8},
+      {"p50_latency_ms", "<f8", 8},
+      {"p99_latency_ms", "<f8", 8},
+      {"p999_latency_ms", "<f8", 8},
+      {"max_latency_ms", "<f8", 8},
+      {"task_target", "<u4", 4},
+      {"task_completed", "|u1", 1},
+      {"task_time_s", "<f8", 8},
+      {"direction", "|u1", 1},
+      {"energy_j", "<f8", 8},
+      {"battery_life_h", "<f8", 8}
+    }),
+    packets (root + "/packets", {
+      {"run", "<u4", 4},
+      {"flow", "<u4", 4},
+      {"tx_time_ns", "<i8", 8},
+      {"rx_time_ns", "<i8", 8},
+      {"size", "<u4", 4}
+    }),
+    windows (root + "/windows", {
+      {"run", "<u4", 4},
+      {"window_start_s", "<f8", 8},
+      {"flow", "<u4", 4},
+      {"tx_packets", "<u4", 4},
+      {"rx_packets", "<u4", 4},
+      {"loss_pct", "<f8", 8},
+      {"throughput_kbps", "<f8", 8},
+      {"p50_latency_ms", "<f8", 8},
+      {"p99_latency_ms", "<f8", 8},
+      {"max_latency_ms", "<f8", 8}
+    })
+{
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_COLUMNAR_H */
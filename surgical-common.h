@@ -0,0 +1,67 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Shared includes and the log component of the surgical IoMT scenario
+ * library. Every surgical-*.h header starts here; each main is a single
+ * translation unit, so the library is header-only and all three programs
+ * build from the same code.
+ */
+
+#ifndef SURGICAL_COMMON_H
+#define SURGICAL_COMMON_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+#include "ns3/spectrum-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/netanim-module.h"
+#include "ns3/energy-module.h"
+#include "ns3/csma-module.h"
+#include "ns3/tap-bridge-module.h"
+#include <iomanip>
+#include <map>
+#include <set>
+#include <fstream>  // For CSV export
+#include <sstream>
+#include <limits>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <sys/wait.h>  // Sweep worker processes
+#include <unistd.h>
+#include <sys/resource.h>  // Peak RSS
+#include <sys/stat.h>  // mkdir for binary results
+#include <cerrno>
+#include <memory>
+#include <cmath>
+#include <array>
+#include <unordered_map>
+#include <typeindex>
+#include <tuple>
+#include <cxxabi.h>  // Event source names for the profiler
+#include <atomic>
+#include <cstring>
+#include <sys/mman.h>  // Shared-memory sweep queues
+#include <fcntl.h>  // Packet trace file
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+#include <new>  // Allocation counting in the benchmark
+#include <sys/socket.h>  // Live telemetry
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SurgicalIoMT");
+
+} // namespace ns3
+
+#endif /* SURGICAL_COMMON_H */
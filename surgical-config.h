@@ -0,0 +1,424 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Scenario files: JSON or YAML descriptions of a scenario, read once at
+ * startup instead of editing and rebuilding the programs
+ */
+
+#ifndef SURGICAL_CONFIG_H
+#define SURGICAL_CONFIG_H
+
+#include "surgical-common.h"
+
+namespace ns3 {
+
+// ===== Scenario files =====
+// A scenario file is one JSON object or YAML mapping whose leaves are the
+// sweep keys (robotInterval, safetyLatencyMs, ...). Leaves may be grouped
+// into sections; a section name is either only a heading ("traffic",
+// "phy") or the prefix of its keys, so
+//   robot: {interval: 1ms, packetSize: 32}   sets robotInterval/robotPacketSize
+//   thresholds: {safetyLatencyMs: 20}        sets safetyLatencyMs
+// ScenarioKeyCandidates lists the names a leaf may stand for. A list of
+// scalars becomes a comma-separated value (mobileClasses: [vital, video]).
+//
+// Only what scenario files need is parsed: JSON without null, and YAML block
+// mappings with scalars, [a, b] flow lists and "- a" block lists (no
+// anchors, multi-line strings or flow mappings).
+
+struct ScenarioFileEntry {
+  std::vector<std::string> path;  // enclosing sections, then the leaf key
+  std::string value;
+  uint32_t line;
+};
+
+// Longest name first: path {"robot", "packetSize"} gives robotPacketSize,
+// then packetSize
+inline std::vector<std::string> ScenarioKeyCandidates (const std::vector<std::string>& path)
+{
+  std::vector<std::string> candidates;
+  for (size_t first = 0; first < path.size (); ++first)
+    {
+      std::string key = path[first];
+      for (size_t i = first + 1; i < path.size (); ++i)
+        {
+          std::string part = path[i];
+          if (!part.empty ())
+            {
+              part[0] = std::toupper (static_cast<unsigned char> (part[0]));
+            }
+          key += part;
+        }
+      candidates.push_back (key);
+    }
+  return candidates;
+}
+
+// Recursive descent over one JSON document
+class JsonScenarioReader
+{
+public:
+  JsonScenarioReader (const std::string& text, const std::string& file);
+  std::vector<ScenarioFileEntry> Read ();
+
+private:
+  void SkipSpace ();
+  bool Consume (char c);
+  void Expect (char c);
+  void ParseObject (std::vector<std::string>& path);
+  void ParseValue (std::vector<std::string>& path);
+  std::string ParseScalar ();
+  std::string ParseString ();
+
+  const std::string& m_text;
+  const std::string& m_file;
+  size_t m_pos;
+  uint32_t m_line;
+  std::vector<ScenarioFileEntry> m_entries;
+};
+
+inline JsonScenarioReader::JsonScenarioReader (const std::string& text, const std::string& file)
+  : m_text (text),
+    m_file (file),
+    m_pos (0),
+    m_line (1)
+{
+}
+
+inline std::vector<ScenarioFileEntry> JsonScenarioReader::Read ()
+{
+  std::vector<std::string> path;
+  SkipSpace ();
+  ParseObject (path);
+  SkipSpace ();
+  if (m_pos != m_text.size ())
+    {
+      NS_FATAL_ERROR (m_file << ":" << m_line << ": text after the top-level object");
+    }
+  return m_entries;
+}
+
+inline void JsonScenarioReader::SkipSpace ()
+{
+  while (m_pos < m_text.size () && std::isspace (static_cast<unsigned char> (m_text[m_pos])))
+    {
+      if (m_text[m_pos++] == '\n')
+        {
+          ++m_line;
+        }
+    }
+}
+
+inline bool JsonScenarioReader::Consume (char c)
+{
+  SkipSpace ();
+  if (m_pos < m_text.size () && m_text[m_pos] == c)
+    {
+      ++m_pos;
+      return true;
+    }
+  return false;
+}
+
+inline void JsonScenarioReader::Expect (char c)
+{
+  if (!Consume (c))
+    {
+      NS_FATAL_ERROR (m_file << ":" << m_line << ": expected '" << c << "'");
+    }
+}
+
+inline void JsonScenarioReader::ParseObject (std::vector<std::string>& path)
+{
+  Expect ('{');
+  if (Consume ('}'))
+    {
+      return;
+    }
+  do
+    {
+      SkipSpace ();
+      path.push_back (ParseString ());
+      Expect (':');
+      ParseValue (path);
+      path.pop_back ();
+    }
+  while (Consume (','));
+  Expect ('}');
+}
+
+inline void JsonScenarioReader::ParseValue (std::vector<std::string>& path)
+{
+  SkipSpace ();
+  uint32_t line = m_line;
+  if (m_pos < m_text.size () && m_text[m_pos] == '{')
+    {
+      ParseObject (path);
+      return;
+    }
+  std::string value;
+  if (Consume ('['))
+    {
+      if (!Consume (']'))
+        {
+          do
+            {
+              SkipSpace ();
+              value += (value.empty () ? "" : ",") + ParseScalar ();
+            }
+          while (Consume (','));
+          Expect (']');
+        }
+    }
+  else
+    {
+      value = ParseScalar ();
+    }
+  m_entries.push_back ({path, value, line});
+}
+
+inline std::string JsonScenarioReader::ParseScalar ()
+{
+  if (m_pos < m_text.size () && m_text[m_pos] == '"')
+    {
+      return ParseString ();
+    }
+  size_t start = m_pos;
+  while (m_pos < m_text.size () && (std::isalnum (static_cast<unsigned char> (m_text[m_pos]))
+                                    || m_text[m_pos] == '-' || m_text[m_pos] == '+'
+                                    || m_text[m_pos] == '.'))
+    {
+      ++m_pos;
+    }
+  std::string token = m_text.substr (start, m_pos - start);
+  if (token.empty () || token == "null")
+    {
+      NS_FATAL_ERROR (m_file << ":" << m_line << ": expected a string, number or boolean");
+    }
+  return token;
+}
+
+inline std::string JsonScenarioReader::ParseString ()
+{
+  if (m_pos >= m_text.size () || m_text[m_pos] != '"')
+    {
+      NS_FATAL_ERROR (m_file << ":" << m_line << ": expected a string");
+    }
+  std::string value;
+  for (++m_pos; m_pos < m_text.size () && m_text[m_pos] != '"'; ++m_pos)
+    {
+      char c = m_text[m_pos];
+      if (c == '\n')
+        {
+          break;
+        }
+      if (c == '\\' && m_pos + 1 < m_text.size ())
+        {
+          c = m_text[++m_pos];
+          c = (c == 'n') ? '\n' : (c == 't') ? '\t' : c;
+        }
+      value += c;
+    }
+  if (m_pos >= m_text.size () || m_text[m_pos] != '"')
+    {
+      NS_FATAL_ERROR (m_file << ":" << m_line << ": unterminated string");
+    }
+  ++m_pos;
+  return value;
+}
+
+inline std::string TrimScenarioToken (const std::string& s)
+{
+  size_t begin = s.find_first_not_of (" \t\r");
+  if (begin == std::string::npos)
+    {
+      return "";
+    }
+  return s.substr (begin, s.find_last_not_of (" \t\r") - begin + 1);
+}
+
+// Strip one level of YAML quotes
+inline std::string UnquoteScenarioToken (const std::string& s)
+{
+  std::string t = TrimScenarioToken (s);
+  if (t.size () >= 2 && (t[0] == '"' || t[0] == '\'') && t.back () == t[0])
+    {
+      return t.substr (1, t.size () - 2);
+    }
+  return t;
+}
+
+// YAML comments start at a '#' outside quotes, at the start of the line or
+// after a blank
+inline std::string StripYamlComment (const std::string& line)
+{
+  char quote = 0;
+  for (size_t i = 0; i < line.size (); ++i)
+    {
+      char c = line[i];
+      if (quote)
+        {
+          quote = (c == quote) ? 0 : quote;
+        }
+      else if (c == '"' || c == '\'')
+        {
+          quote = c;
+        }
+      else if (c == '#' && (i == 0 || line[i - 1] == ' ' || line[i - 1] == '\t'))
+        {
+          return line.substr (0, i);
+        }
+    }
+  return line;
+}
+
+inline std::vector<ScenarioFileEntry> ParseYamlScenario (const std::string& text, const std::string& file)
+{
+  // Mapping keys enclosing the current line, each with the block list it
+  // holds if its value is a "- item" list
+  struct OpenKey {
+    size_t indent;
+    std::string key;
+    bool hasChildren;
+    std::vector<std::string> items;
+    uint32_t line;
+  };
+  std::vector<OpenKey> open;
+  std::vector<ScenarioFileEntry> entries;
+
+  auto keys = [&open] () {
+    std::vector<std::string> path;
+    for (const auto& k : open)
+      {
+        path.push_back (k.key);
+      }
+    return path;
+  };
+  auto close = [&] (size_t indent) {
+    while (!open.empty () && open.back ().indent >= indent)
+      {
+        if (!open.back ().items.empty ())
+          {
+            std::string value;
+            for (const auto& item : open.back ().items)
+              {
+                value += (value.empty () ? "" : ",") + item;
+              }
+            entries.push_back ({keys (), value, open.back ().line});
+          }
+        open.pop_back ();
+      }
+  };
+
+  std::istringstream in (text);
+  std::string raw;
+  uint32_t lineNo = 0;
+  while (std::getline (in, raw))
+    {
+      ++lineNo;
+      std::string line = StripYamlComment (raw);
+      std::string content = TrimScenarioToken (line);
+      if (content.empty () || content == "---")
+        {
+          continue;
+        }
+      size_t indent = line.find_first_not_of (' ');
+      if (line[indent] == '\t')
+        {
+          NS_FATAL_ERROR (file << ":" << lineNo << ": tabs are not allowed in YAML indentation");
+        }
+
+      if (content[0] == '-' && (content.size () == 1 || content[1] == ' '))
+        {
+          if (open.empty () || open.back ().hasChildren || indent < open.back ().indent)
+            {
+              NS_FATAL_ERROR (file << ":" << lineNo << ": list item outside a list");
+            }
+          open.back ().items.push_back (UnquoteScenarioToken (content.substr (1)));
+          continue;
+        }
+
+      size_t colon = content.find (": ");
+      if (colon == std::string::npos && content.back () == ':')
+        {
+          colon = content.size () - 1;
+        }
+      if (colon == std::string::npos)
+        {
+          NS_FATAL_ERROR (file << ":" << lineNo << ": expected 'key: value', got '" << content << "'");
+        }
+      close (indent);
+      if (!open.empty ())
+        {
+          if (!open.back ().items.empty ())
+            {
+              NS_FATAL_ERROR (file << ":" << lineNo << ": " << open.back ().key << " mixes a list and keys");
+            }
+          open.back ().hasChildren = true;
+        }
+      std::string key = UnquoteScenarioToken (content.substr (0, colon));
+      std::string value = TrimScenarioToken (content.substr (colon + 1));
+      if (value.empty ())
+        {
+          open.push_back ({indent, key, false, {}, lineNo});
+          continue;
+        }
+
+      std::vector<std::string> path = keys ();
+      path.push_back (key);
+      if (value[0] == '{')
+        {
+          NS_FATAL_ERROR (file << ":" << lineNo << ": flow mappings are not supported, indent the keys instead");
+        }
+      if (value[0] == '[')
+        {
+          if (value.back () != ']')
+            {
+              NS_FATAL_ERROR (file << ":" << lineNo << ": unterminated list");
+            }
+          std::istringstream list (value.substr (1, value.size () - 2));
+          std::string item;
+          value.clear ();
+          while (std::getline (list, item, ','))
+            {
+              item = UnquoteScenarioToken (item);
+              if (!item.empty ())
+                {
+                  value += (value.empty () ? "" : ",") + item;
+                }
+            }
+        }
+      else
+        {
+          value = UnquoteScenarioToken (value);
+        }
+      entries.push_back ({path, value, lineNo});
+    }
+  close (0);
+  return entries;
+}
+
+// JSON for *.json or a file starting with '{', YAML otherwise
+inline std::vector<ScenarioFileEntry> ReadScenarioFile (const std::string& path)
+{
+  std::ifstream in (path);
+  if (!in.is_open ())
+    {
+      NS_FATAL_ERROR ("Cannot open scenario file " << path);
+    }
+  std::stringstream buffer;
+  buffer << in.rdbuf ();
+  std::string text = buffer.str ();
+
+  size_t first = text.find_first_not_of (" \t\r\n");
+  bool json = (path.size () > 5 && path.compare (path.size () - 5, 5, ".json") == 0)
+    || (first != std::string::npos && text[first] == '{');
+  if (json)
+    {
+      return JsonScenarioReader (text, path).Read ();
+    }
+  return ParseYamlScenario (text, path);
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_CONFIG_H */
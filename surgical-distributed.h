@@ -0,0 +1,191 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Distributed (MPI) execution: room partitioning and gathering the
+ * per-rank flow totals back to rank 0
+ */
+
+#ifndef SURGICAL_DISTRIBUTED_H
+#define SURGICAL_DISTRIBUTED_H
+
+#include "surgical-collector.h"
+
+#ifdef NS3_MPI
+#include "ns3/mpi-module.h"
+#include <mpi.h>
+#endif
+
+namespace ns3 {
+
+// ===== Distributed execution =====
+// Every rank builds the whole topology; a node belongs to the rank of its
+// system id and only local nodes run applications. Rooms are dealt out
+// round-robin by channel, so each wireless channel lives on one rank, and
+// the fog and cloud nodes are on rank 0: the only links crossing ranks are
+// the AP-fog point-to-point links, whose delay is the lookahead. After the
+// run every rank sends its flow totals to rank 0, which merges them (a
+// flow's sender and receiver may be on different ranks) and reports.
+
+// Enable MPI when argv holds --distributed (or --distributed=1/true); call
+// first thing in main, before any other ns-3 call
+inline bool EnableDistributed (int* argc, char*** argv)
+{
+  bool distributed = false;
+  for (int i = 1; i < *argc; ++i)
+    {
+      std::string arg = (*argv)[i];
+      if (arg == "--distributed" || arg == "--distributed=1" || arg == "--distributed=true")
+        {
+          distributed = true;
+        }
+    }
+  if (!distributed)
+    {
+      return false;
+    }
+#ifdef NS3_MPI
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DistributedSimulatorImpl"));
+  MpiInterface::Enable (argc, argv);
+  return true;
+#else
+  NS_FATAL_ERROR ("--distributed needs ns-3 configured with --enable-mpi");
+  return false;
+#endif
+}
+
+inline void DisableDistributed (bool distributed)
+{
+#ifdef NS3_MPI
+  if (distributed)
+    {
+      MpiInterface::Disable ();
+    }
+#endif
+}
+
+// Rank of this process and number of ranks (0 and 1 when not distributed)
+inline uint32_t DistributedRank ()
+{
+#ifdef NS3_MPI
+  return MpiInterface::IsEnabled () ? MpiInterface::GetSystemId () : 0;
+#else
+  return 0;
+#endif
+}
+
+inline uint32_t DistributedSize ()
+{
+#ifdef NS3_MPI
+  return MpiInterface::IsEnabled () ? MpiInterface::GetSize () : 1;
+#else
+  return 1;
+#endif
+}
+
+// Rooms sharing a channel object (see InstallWifi) must share a rank
+inline uint32_t RoomRank (uint32_t room, uint32_t channels, uint32_t ranks)
+{
+  return (room % channels) % ranks;
+}
+
+// One "F,flow,tx,rx,delayNs,jitterNs,firstTxNs,lastRxNs,histogram" line per
+// flow with traffic, after an "E,events" line
+inline std::string SerializeFlows (const LatencyCollector& collector, uint64_t events)
+{
+  std::ostringstream out;
+  out << "E," << events << "\n";
+  for (uint32_t i = 0; i < collector.GetNFlows (); ++i)
+    {
+      const FlowAggregate& f = collector.GetFlow (i);
+      if (f.txPackets == 0 && f.rxPackets == 0)
+        {
+          continue;
+        }
+      out << "F," << i << "," << f.txPackets << "," << f.rxPackets << ","
+          << f.delaySum.GetNanoSeconds () << "," << f.jitterSum.GetNanoSeconds () << ","
+          << f.timeFirstTxPacket.GetNanoSeconds () << "," << f.timeLastRxPacket.GetNanoSeconds () << ","
+          << f.latency.Serialize () << "\n";
+    }
+  return out.str ();
+}
+
+// Merge another rank's SerializeFlows () text; returns its event count
+inline uint64_t MergeFlows (LatencyCollector& collector, const std::string& text)
+{
+  uint64_t events = 0;
+  std::istringstream in (text);
+  std::string line;
+  while (std::getline (in, line))
+    {
+      std::istringstream row (line);
+      std::string field;
+      std::vector<std::string> f;
+      while (std::getline (row, field, ','))
+        {
+          f.push_back (field);
+        }
+      if (f.size () == 2 && f[0] == "E")
+        {
+          events = std::stoull (f[1]);
+        }
+      else if (f.size () == 9 && f[0] == "F")
+        {
+          FlowAggregate other;
+          other.txPackets = std::stoul (f[2]);
+          other.rxPackets = std::stoul (f[3]);
+          other.delaySum = NanoSeconds (std::stoll (f[4]));
+          other.jitterSum = NanoSeconds (std::stoll (f[5]));
+          other.timeFirstTxPacket = NanoSeconds (std::stoll (f[6]));
+          other.timeLastRxPacket = NanoSeconds (std::stoll (f[7]));
+          other.latency = LatencyHistogram::Deserialize (f[8]);
+          collector.MergeFlow (std::stoul (f[1]), other);
+        }
+    }
+  return events;
+}
+
+// Collective: every rank calls it after Simulator::Run (). Rank 0 ends up
+// with all flows merged into 'collector'; the total event count of all
+// ranks is returned on rank 0, the local count elsewhere.
+inline uint64_t GatherFlows (LatencyCollector& collector, uint64_t localEvents)
+{
+#ifdef NS3_MPI
+  if (!MpiInterface::IsEnabled () || MpiInterface::GetSize () < 2)
+    {
+      return localEvents;
+    }
+  MPI_Comm comm = MpiInterface::GetCommunicator ();
+  int rank = MpiInterface::GetSystemId ();
+  int size = MpiInterface::GetSize ();
+
+  std::string local = (rank == 0) ? std::string () : SerializeFlows (collector, localEvents);
+  int length = local.size ();
+  std::vector<int> lengths (size);
+  MPI_Gather (&length, 1, MPI_INT, lengths.data (), 1, MPI_INT, 0, comm);
+
+  std::vector<int> offsets (size, 0);
+  for (int r = 1; r < size; ++r)
+    {
+      offsets[r] = offsets[r - 1] + lengths[r - 1];
+    }
+  std::vector<char> all (rank == 0 ? offsets[size - 1] + lengths[size - 1] : 0);
+  MPI_Gatherv (local.data (), length, MPI_CHAR, all.data (), lengths.data (), offsets.data (),
+               MPI_CHAR, 0, comm);
+  if (rank != 0)
+    {
+      return localEvents;
+    }
+
+  uint64_t events = localEvents;
+  for (int r = 1; r < size; ++r)
+    {
+      events += MergeFlows (collector, std::string (all.data () + offsets[r], lengths[r]));
+    }
+  return events;
+#else
+  return localEvents;
+#endif
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_DISTRIBUTED_H */
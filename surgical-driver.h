@@ -0,0 +1,956 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Command line, profiles and sweep driver shared by the surgical mains
+ */
+
+#ifndef SURGICAL_DRIVER_H
+#define SURGICAL_DRIVER_H
+
+#include "surgical-export.h"
+#include "surgical-config.h"
+
+namespace ns3 {
+
+// One entry of a sweep: scenario index in the sweep file, replication and results
+struct SweepRun {
+  uint32_t scenario;
+  uint32_t replication;
+  ScenarioConfig config;
+  ScenarioResult result;
+};
+
+// ===== Sweep driver =====
+
+// Apply one sweep-file override to cfg; returns false for an unknown key
+inline bool SetScenarioParameter (ScenarioConfig& cfg, const std::string& key,
+                                  const std::string& value)
+{
+  if (key == "simulationTime") cfg.simulationTime = std::stod (value);
+  else if (key == "rooms") cfg.rooms = std::stoul (value);
+  else if (key == "robotsPerRoom") cfg.robotsPerRoom = std::stoul (value);
+  else if (key == "endoscopesPerRoom") cfg.endoscopesPerRoom = std::stoul (value);
+  else if (key == "vitalsPerRoom") cfg.vitalsPerRoom = std::stoul (value);
+  else if (key == "roomSpacing") cfg.roomSpacing = std::stod (value);
+  else if (key == "ssid") cfg.ssid = value;
+  else if (key == "channelPlan") cfg.channelPlan = value;
+  else if (key == "neighbourBss") cfg.neighbourBss = std::stoul (value);
+  else if (key == "backgroundStations") cfg.backgroundStations = std::stoul (value);
+  else if (key == "backgroundTraffic") cfg.backgroundTraffic = value;
+  else if (key == "backgroundRateMbps") cfg.backgroundRateMbps = std::stod (value);
+  else if (key == "backgroundPacketSize") cfg.backgroundPacketSize = std::stoul (value);
+  else if (key == "backgroundStart") cfg.backgroundStart = Time (value);
+  else if (key == "neighbourDistance") cfg.neighbourDistance = std::stod (value);
+  else if (key == "bssColoring") cfg.bssColoring = value;
+  else if (key == "obssPdLevel") cfg.obssPdLevel = std::stod (value);
+  else if (key == "serverTier") cfg.serverTier = value;
+  else if (key == "fogLinkRate") cfg.fogLinkRate = value;
+  else if (key == "fogLinkDelay") cfg.fogLinkDelay = Time (value);
+  else if (key == "cloudLinkRate") cfg.cloudLinkRate = value;
+  else if (key == "cloudLinkDelay") cfg.cloudLinkDelay = Time (value);
+  else if (key == "cloudLinkLossPercent") cfg.cloudLinkLossPercent = std::stod (value);
+  else if (key == "mobility") cfg.mobility = value;
+  else if (key == "mobileClasses") cfg.mobileClasses = value;
+  else if (key == "trajectoryFile") cfg.trajectoryFile = value;
+  else if (key == "mobilitySpeed") cfg.mobilitySpeed = std::stod (value);
+  else if (key == "mobilityPause") cfg.mobilityPause = Time (value);
+  else if (key == "obstaclesPerRoom") cfg.obstaclesPerRoom = std::stoul (value);
+  else if (key == "obstacleLossDb") cfg.obstacleLossDb = std::stod (value);
+  else if (key == "obstacleRadius") cfg.obstacleRadius = std::stod (value);
+  else if (key == "mobilityUpdateInterval") cfg.mobilityUpdateInterval = Time (value);
+  else if (key == "positionCell") cfg.positionCell = std::stod (value);
+  else if (key == "trafficModel") cfg.trafficModel = value;
+  else if (key == "videoBitrateMbps") cfg.videoBitrateMbps = std::stod (value);
+  else if (key == "videoGopLength") cfg.videoGopLength = std::stoul (value);
+  else if (key == "videoIFrameRatio") cfg.videoIFrameRatio = std::stod (value);
+  else if (key == "warmStart") cfg.warmStart = (value == "1" || value == "true");
+  else if (key == "warmStartSettle") cfg.warmStartSettle = Time (value);
+  else if (key == "profiling") cfg.profiling = (value == "1" || value == "true");
+  else if (key == "resultCache") cfg.resultCache = value;
+  else if (key == "profileSampleEvery") cfg.profileSampleEvery = std::stoul (value);
+  else if (key == "realtime") cfg.realtime = (value == "1" || value == "true");
+  else if (key == "realtimeSync") cfg.realtimeSync = value;
+  else if (key == "realtimeHardLimit") cfg.realtimeHardLimit = Time (value);
+  else if (key == "realtimeProbe") cfg.realtimeProbe = Time (value);
+  else if (key == "realtimeLagBudgetMs") cfg.realtimeLagBudgetMs = std::stod (value);
+  else if (key == "tapStations") cfg.tapStations = std::stoul (value);
+  else if (key == "tapEdge") cfg.tapEdge = (value == "1" || value == "true");
+  else if (key == "tapPrefix") cfg.tapPrefix = value;
+  else if (key == "tapEdgeAddress") cfg.tapEdgeAddress = value;
+  else if (key == "tapEdgeMask") cfg.tapEdgeMask = value;
+  else if (key == "qos") cfg.qos = (value == "1" || value == "true");
+  else if (key == "txPowerDbm") cfg.txPowerDbm = std::stod (value);
+  else if (key == "dataMode") cfg.dataMode = value;
+  else if (key == "fidelity") cfg.fidelity = value;
+  else if (key == "rateControl") cfg.rateControl = value;
+  else if (key == "fastRange") cfg.fastRange = std::stod (value);
+  else if (key == "wallLossDb") cfg.wallLossDb = std::stod (value);
+  else if (key == "batteryClasses") cfg.batteryClasses = value;
+  else if (key == "batteryEnergyJ") cfg.batteryEnergyJ = std::stod (value);
+  else if (key == "batteryVoltage") cfg.batteryVoltage = std::stod (value);
+  else if (key == "powerSave") cfg.powerSave = value;
+  else if (key == "twtInterval") cfg.twtInterval = Time (value);
+  else if (key == "twtWakeDuration") cfg.twtWakeDuration = Time (value);
+  else if (key == "robotTraffic") cfg.robotTraffic = (value == "1" || value == "true");
+  else if (key == "robotDownlink") cfg.robotDownlink = (value == "1" || value == "true");
+  else if (key == "robotStart") cfg.robotStart = Time (value);
+  else if (key == "videoTraffic") cfg.videoTraffic = (value == "1" || value == "true");
+  else if (key == "videoStart") cfg.videoStart = Time (value);
+  else if (key == "videoDownlink") cfg.videoDownlink = (value == "1" || value == "true");
+  else if (key == "vitalTraffic") cfg.vitalTraffic = (value == "1" || value == "true");
+  else if (key == "vitalStart") cfg.vitalStart = Time (value);
+  else if (key == "vitalDownlink") cfg.vitalDownlink = (value == "1" || value == "true");
+  else if (key == "robotMaxPackets") cfg.robotMaxPackets = std::stoul (value);
+  else if (key == "robotInterval") cfg.robotInterval = Time (value);
+  else if (key == "robotPacketSize") cfg.robotPacketSize = std::stoul (value);
+  else if (key == "robotPort") cfg.robotPort = std::stoul (value);
+  else if (key == "videoMaxPackets") cfg.videoMaxPackets = std::stoul (value);
+  else if (key == "videoInterval") cfg.videoInterval = Time (value);
+  else if (key == "videoPacketSize") cfg.videoPacketSize = std::stoul (value);
+  else if (key == "videoPort") cfg.videoPort = std::stoul (value);
+  else if (key == "vitalMaxPackets") cfg.vitalMaxPackets = std::stoul (value);
+  else if (key == "vitalInterval") cfg.vitalInterval = Time (value);
+  else if (key == "vitalPacketSize") cfg.vitalPacketSize = std::stoul (value);
+  else if (key == "vitalPort") cfg.vitalPort = std::stoul (value);
+  else if (key == "windowInterval") cfg.windowInterval = Time (value);
+  else if (key == "telemetryUdp") cfg.telemetryUdp = value;
+  else if (key == "telemetryHttpPort") cfg.telemetryHttpPort = std::stoul (value);
+  else if (key == "telemetryInterval") cfg.telemetryInterval = std::stod (value);
+  else if (key == "telemetryPoll") cfg.telemetryPoll = Time (value);
+  else if (key == "packetTrace") cfg.packetTrace = (value == "1" || value == "true");
+  else if (key == "packetTraceArenaKb") cfg.packetTraceArenaKb = std::stoul (value);
+  else if (key == "safetyStop") cfg.safetyStop = (value == "1" || value == "true");
+  else if (key == "safetyCheckInterval") cfg.safetyCheckInterval = Time (value);
+  else if (key == "safetyLatencyMs") cfg.safetyLatencyMs = std::stod (value);
+  else if (key == "safetyTaskSec") cfg.safetyTaskSec = std::stod (value);
+  else return false;
+  return true;
+}
+
+// The "profile" entry at the top of a scenario file, or "" without one
+inline std::string ScenarioFileProfile (const std::vector<ScenarioFileEntry>& entries)
+{
+  for (const auto& e : entries)
+    {
+      if (e.path.size () == 1 && e.path[0] == "profile")
+        {
+          return e.value;
+        }
+    }
+  return "";
+}
+
+// Apply every entry of a scenario file to cfg under the first of its
+// candidate names that is a sweep key
+inline void ApplyScenarioFile (ScenarioConfig& cfg, const std::vector<ScenarioFileEntry>& entries,
+                               const std::string& path)
+{
+  for (const auto& e : entries)
+    {
+      if (e.path.size () == 1 && e.path[0] == "profile")
+        {
+          continue;
+        }
+      std::vector<std::string> candidates = ScenarioKeyCandidates (e.path);
+      bool known = false;
+      for (const auto& key : candidates)
+        {
+          try
+            {
+              known = SetScenarioParameter (cfg, key, e.value);
+            }
+          catch (const std::exception&)
+            {
+              NS_FATAL_ERROR (path << ":" << e.line << ": bad value '" << e.value << "' for " << key);
+            }
+          if (known)
+            {
+              break;
+            }
+        }
+      if (!known)
+        {
+          NS_FATAL_ERROR (path << ":" << e.line << ": unknown key " << candidates.front ());
+        }
+    }
+}
+
+// Read the scenario list, expanding comma-separated values into their
+// cartesian product. Unspecified keys keep the values of 'base'.
+inline std::vector<ScenarioConfig> LoadSweepFile (const std::string& path,
+                                                  const ScenarioConfig& base)
+{
+  std::ifstream in (path);
+  if (!in.is_open ())
+    {
+      NS_FATAL_ERROR ("Cannot open sweep file " << path);
+    }
+
+  std::vector<ScenarioConfig> scenarios;
+  std::string line;
+  uint32_t lineNo = 0;
+  while (std::getline (in, line))
+    {
+      ++lineNo;
+      line = line.substr (0, line.find ('#'));
+      std::istringstream tokens (line);
+      std::vector<ScenarioConfig> grid = {base};
+      bool hasOverrides = false;
+      std::string token;
+      while (tokens >> token)
+        {
+          size_t eq = token.find ('=');
+          if (eq == std::string::npos || eq + 1 == token.size ())
+            {
+              NS_FATAL_ERROR (path << ":" << lineNo << ": expected key=value, got '" << token << "'");
+            }
+          std::string key = token.substr (0, eq);
+          std::vector<std::string> values;
+          std::istringstream list (token.substr (eq + 1));
+          std::string value;
+          while (std::getline (list, value, ','))
+            {
+              if (!value.empty ()) values.push_back (value);
+            }
+
+          std::vector<ScenarioConfig> expanded;
+          for (const auto& partial : grid)
+            {
+              for (const auto& v : values)
+                {
+                  ScenarioConfig c = partial;
+                  bool known = false;
+                  try
+                    {
+                      known = SetScenarioParameter (c, key, v);
+                    }
+                  catch (const std::exception&)
+                    {
+                      NS_FATAL_ERROR (path << ":" << lineNo << ": bad value '" << v << "' for " << key);
+                    }
+                  if (!known)
+                    {
+                      NS_FATAL_ERROR (path << ":" << lineNo << ": unknown parameter " << key);
+                    }
+                  expanded.push_back (c);
+                }
+            }
+          grid.swap (expanded);
+          hasOverrides = true;
+        }
+      if (hasOverrides)
+        {
+          scenarios.insert (scenarios.end (), grid.begin (), grid.end ());
+        }
+    }
+  return scenarios;
+}
+
+// Ring size of each worker's result queue; a D record is one device with
+// its histogram, far below this
+static const uint64_t g_sweepQueueBytes = 4 << 20;
+// Jobs are one short line each and a worker has at most one queued
+static const uint64_t g_sweepJobQueueBytes = 4096;
+
+// Worker body: take "J,<run>,<scenario>,<replication>,<rngRun>" jobs from
+// 'jobs' until a "Q" and push each run's result rows (see ResultRows) to
+// 'results'; the closing "R" row marks the run complete. A worker whose parent is gone exits.
+inline void RunSweepWorker (const std::vector<ScenarioConfig>& scenarios, uint32_t worker,
+                            pid_t parent, SweepQueue& jobs, SweepQueue& results)
+{
+  // Workers never share column files: each appends to its own shard
+  std::unique_ptr<BinaryResults> binary;
+  if (WantsBinary (scenarios.front ()))
+    {
+      binary.reset (new BinaryResults (BinaryResultsDir (scenarios.front ()) + "/shard" + std::to_string (worker)));
+    }
+
+  std::string job;
+  while (true)
+    {
+      if (!jobs.Pop (job))
+        {
+          if (getppid () != parent)
+            {
+              return;
+            }
+          usleep (200);
+          continue;
+        }
+      if (job == "Q")
+        {
+          return;
+        }
+      uint32_t i, scenario, replication, rngRun;
+      char comma;
+      std::istringstream fields (job.substr (2));
+      fields >> i >> comma >> scenario >> comma >> replication >> comma >> rngRun;
+      ScenarioConfig config = scenarios.at (scenario);
+      config.rngRun = rngRun;
+
+      ScenarioResult result = RunCachedScenario (config, binary.get ());
+      if (binary)
+        {
+          ExportMetricsToBinary (result.devices, BuildTaskTargets (config), config.rngRun, *binary);
+        }
+      if (result.profile.enabled)
+        {
+          ExportProfileToJSON (result, config, ProfileJsonPath (config));
+        }
+      if (WantsCsv (config) && !result.positions.empty ())
+        {
+          ExportPositionLatencyToCSV (result.positions, PositionsCsvPath (config));
+        }
+      for (const auto& row : ResultRows (i, result))
+        {
+          results.Push (row);
+        }
+    }
+}
+
+// Apply one worker row to the run it belongs to; returns the run index once
+// its closing "R" row arrives, -1 otherwise
+inline int64_t MergeSweepRow (const std::string& line, std::vector<SweepRun>& runs)
+{
+  std::vector<std::string> f = SplitResultRow (line);
+  if (f.size () < 2 || (f[0] != "D" && f[0] != "P" && f[0] != "R"))
+    {
+      return -1;
+    }
+  uint32_t i = std::stoul (f[1]);
+  return ApplyResultRow (f, runs.at (i).result) ? int64_t (i) : -1;
+}
+
+inline void WriteSweepCsvHeader (std::ostream& csvFile)
+{
+  csvFile << std::fixed << std::setprecision (6);
+  csvFile << "Run,Scenario,Replication,RngRun,SimulationTimeSec,"
+          << "Rooms,Stations,Events,WallSec,PeakRssMb,Cached,"
+          << "Qos,ServerTier,ChannelPlan,Fidelity,NeighbourBss,BackgroundTraffic,BssColoring,ObssPdLevel,BackgroundMbps,"
+          << "BatteryClasses,PowerSave,TwtIntervalMs,TwtWakeMs,"
+          << "Realtime,RealtimeLagP99Ms,RealtimeLagMaxMs,RealtimeLatePercent,"
+          << "SimulatedSec,SafetyStop,SafetyStopSec,SafetyStopDevice,SafetyStopCause,"
+          << "RobotPacketSize,RobotIntervalMs,RobotMaxPackets,"
+          << "VideoPacketSize,VideoIntervalMs,VideoMaxPackets,"
+          << "VitalPacketSize,VitalIntervalMs,VitalMaxPackets,"
+          << "Device,TxPackets,RxPackets,LossPercent,AvgLatencyMs,AvgJitterMs,"
+          << "TaskTargetPackets,TaskCompleted,TaskCompletionTimeSec,SuccessRatePercent,"
+          << "P50LatencyMs,P99LatencyMs,P999LatencyMs,MaxLatencyMs,Direction,EnergyJ,BatteryLifeHours\n";
+}
+
+// One row per device of run i
+inline void WriteSweepRunToCSV (std::ostream& csvFile, uint32_t i, const SweepRun& run)
+{
+  const ScenarioConfig& c = run.config;
+  std::map<std::string, uint32_t> taskTargets = BuildTaskTargets (c);
+  const ScenarioResult& result = run.result;
+  for (const auto& r : result.devices)
+    {
+      uint32_t target = taskTargets.at (r.name);
+      double successRate = (target > 0) ? (double)r.rxPackets / target * 100.0 : 0.0;
+      csvFile << i << "," << run.scenario << "," << run.replication << ","
+              << c.rngRun << "," << c.simulationTime << ","
+              << c.rooms << "," << result.stations << "," << result.events << ","
+              << result.wallSeconds << "," << result.peakRssMb << "," << (result.cached ? "Yes" : "No") << ","
+              << (c.qos ? "Yes" : "No") << "," << c.serverTier << "," << c.channelPlan << ","
+              << c.fidelity << "," << c.neighbourBss << "," << c.backgroundTraffic << ","
+              << c.bssColoring << "," << c.obssPdLevel << "," << result.backgroundMbps << ","
+              << ClassListLabel (c.batteryClasses) << "," << c.powerSave << "," << c.twtInterval.GetNanoSeconds () / 1e6 << ","
+              << c.twtWakeDuration.GetNanoSeconds () / 1e6 << ","
+              << (c.realtime ? "Yes" : "No") << "," << result.realtime.lag.GetQuantileMs (0.99) << ","
+              << result.realtime.lag.GetMax () / 1e6 << "," << result.realtime.LatePercent () << ","
+              << result.simulatedSeconds << "," << (result.safety.stopped ? "Yes" : "No") << ","
+              << result.safety.time.GetSeconds () << "," << result.safety.device << ","
+              << result.safety.cause << ","
+              << c.robotPacketSize << "," << c.robotInterval.GetNanoSeconds () / 1e6 << ","
+              << c.robotMaxPackets << ","
+              << c.videoPacketSize << "," << c.videoInterval.GetNanoSeconds () / 1e6 << ","
+              << c.videoMaxPackets << ","
+              << c.vitalPacketSize << "," << c.vitalInterval.GetNanoSeconds () / 1e6 << ","
+              << c.vitalMaxPackets << ","
+              << r.name << "," << r.txPackets << "," << r.rxPackets << ","
+              << r.lossRate << "," << r.avgLatencyMs << "," << r.avgJitterMs << ","
+              << target << "," << (r.taskCompleted ? "Yes" : "No") << ","
+              << r.taskCompletionTime << "," << successRate << ","
+              << r.latency.GetQuantileMs (0.50) << "," << r.latency.GetQuantileMs (0.99) << ","
+              << r.latency.GetQuantileMs (0.999) << "," << r.latency.GetMax () / 1e6 << ","
+              << DirectionLabel (r.direction) << "," << r.energyJ << "," << r.batteryLifeHours << "\n";
+    }
+}
+
+// surgical_sweep.csv -> surgical_sweep_summary.csv
+inline std::string SweepSummaryPath (const std::string& output)
+{
+  size_t dot = output.rfind ('.');
+  size_t slash = output.rfind ('/');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+      return output + "_summary";
+    }
+  return output.substr (0, dot) + "_summary" + output.substr (dot);
+}
+
+// Replication bookkeeping of one sweep scenario. A replication in flight
+// on a worker that died is re-run once on another worker (same RngRun);
+// lost a second time, it is given up and the scenario is flagged.
+struct SweepScenarioState {
+  uint32_t issued = 0;  // replications 0..issued-1 handed out at least once
+  uint32_t completed = 0;
+  std::vector<uint32_t> retry;  // lost once, waiting to be re-run
+  std::set<uint32_t> retried;
+  uint32_t lost = 0;  // given up
+  bool converged = false;
+};
+
+// Hand runs out one at a time to 'workers' forked processes and drain their
+// result queues while they run: every finished run is written to the sweep
+// CSV (in completion order, the Run column gives its index), folded into
+// the replication summaries and dropped, so the parent's memory does not
+// grow with the number of runs. Scenarios are served in order; once one has
+// minReplications results, every further result is checked against the
+// policy's CI targets and the scenario stops as soon as they are met.
+// Replication r of scenario s always runs with RngRun
+// firstRngRun + s * maxReplications + r, whichever worker runs it.
+inline void RunSweep (const std::vector<ScenarioConfig>& scenarios, const ReplicationPolicy& policy,
+                      uint32_t workers, uint32_t firstRngRun, const std::string& output)
+{
+  if (workers == 0)
+    {
+      workers = std::max<long> (1, sysconf (_SC_NPROCESSORS_ONLN));
+    }
+  workers = std::min<uint64_t> (workers, uint64_t (scenarios.size ()) * policy.maxReplications);
+
+  std::ofstream csvFile (output);
+  if (!csvFile.is_open ())
+    {
+      NS_FATAL_ERROR ("Failed to open " << output << " for writing");
+    }
+  WriteSweepCsvHeader (csvFile);
+
+  std::cout << "🔁 Sweep: " << scenarios.size () << " scenarios, ";
+  if (policy.IsAdaptive ())
+    {
+      std::cout << policy.minReplications << "-" << policy.maxReplications << " replications until the 95% CI of robot p99";
+      if (policy.ciP99Ms > 0)
+        std::cout << " is within ±" << policy.ciP99Ms << " ms";
+      if (policy.ciSuccessPercent > 0)
+        std::cout << (policy.ciP99Ms > 0 ? " and of" : "") << " task success within ±" << policy.ciSuccessPercent << " %";
+    }
+  else
+    {
+      std::cout << policy.maxReplications << " replications each";
+    }
+  std::cout << ", on " << workers << " worker processes\n";
+  std::cout.flush ();
+  auto wallStart = std::chrono::steady_clock::now ();
+
+  std::vector<SweepQueue*> jobs;
+  std::vector<SweepQueue*> results;
+  std::vector<pid_t> pids;
+  pid_t parent = getpid ();
+  for (uint32_t w = 0; w < workers; ++w)
+    {
+      jobs.push_back (SweepQueue::Map (g_sweepJobQueueBytes));
+      results.push_back (SweepQueue::Map (g_sweepQueueBytes));
+      csvFile.flush ();
+      pid_t pid = fork ();
+      if (pid < 0)
+        {
+          NS_FATAL_ERROR ("fork() failed for sweep worker " << w);
+        }
+      if (pid == 0)
+        {
+          RunSweepWorker (scenarios, w, parent, *jobs[w], *results[w]);
+          _exit (0);
+        }
+      pids.push_back (pid);
+    }
+
+  std::vector<SweepRun> runs;
+  std::vector<SweepScenarioState> state (scenarios.size ());
+  std::vector<int64_t> busy (workers, -1);  // run in flight on each worker
+  SweepAggregator aggregator;
+  uint32_t completed = 0;
+
+  auto drain = [&] () {
+    bool any = false;
+    std::string record;
+    for (uint32_t w = 0; w < workers; ++w)
+      {
+        while (results[w]->Pop (record))
+          {
+            any = true;
+            int64_t done = MergeSweepRow (record, runs);
+            if (done < 0)
+              {
+                continue;
+              }
+            SweepRun& run = runs[done];
+            WriteSweepRunToCSV (csvFile, done, run);
+            aggregator.Add (run.scenario, run.config, run.result);
+            run.result = ScenarioResult ();
+            busy[w] = -1;
+            ++completed;
+            SweepScenarioState& s = state[run.scenario];
+            ++s.completed;
+            if (!s.converged && IsConverged (aggregator.GetSummary (run.scenario), policy))
+              {
+                s.converged = true;
+                aggregator.GetSummary (run.scenario).converged = true;
+              }
+          }
+      }
+    return any;
+  };
+  // First scenario that still needs a run. Scenarios are served in order,
+  // so a scenario's runs still in flight when it converges (at most one
+  // per other worker) are the only overshoot past its CI targets.
+  auto next = [&] () -> int64_t {
+    for (uint32_t s = 0; s < state.size (); ++s)
+      {
+        if (!state[s].converged && (!state[s].retry.empty () || state[s].issued < policy.maxReplications))
+          {
+            return s;
+          }
+      }
+    return -1;
+  };
+
+  uint32_t failed = 0;
+  while (true)
+    {
+      std::vector<uint32_t> died;
+      for (uint32_t w = 0; w < workers; ++w)
+        {
+          int status = 0;
+          if (pids[w] > 0 && waitpid (pids[w], &status, WNOHANG) == pids[w])
+            {
+              ++failed;
+              pids[w] = 0;
+              died.push_back (w);
+            }
+        }
+      // A dead worker's last rows are all queued by now
+      bool any = drain ();
+      for (uint32_t w : died)
+        {
+          if (busy[w] >= 0)
+            {
+              SweepScenarioState& s = state[runs[busy[w]].scenario];
+              uint32_t replication = runs[busy[w]].replication;
+              if (s.retried.insert (replication).second)
+                {
+                  s.retry.push_back (replication);
+                }
+              else
+                {
+                  ++s.lost;
+                }
+              busy[w] = -1;
+            }
+        }
+
+      bool working = false;
+      for (uint32_t w = 0; w < workers; ++w)
+        {
+          int64_t s = (pids[w] > 0 && busy[w] < 0) ? next () : -1;
+          if (s >= 0)
+            {
+              uint32_t replication;
+              if (!state[s].retry.empty ())
+                {
+                  replication = state[s].retry.back ();
+                  state[s].retry.pop_back ();
+                }
+              else
+                {
+                  replication = state[s].issued++;
+                }
+              SweepRun run {static_cast<uint32_t> (s), replication, scenarios[s], ScenarioResult ()};
+              run.config.rngRun = firstRngRun + s * policy.maxReplications + replication;
+              busy[w] = runs.size ();
+              std::ostringstream job;
+              job << "J," << runs.size () << "," << s << "," << replication << "," << run.config.rngRun;
+              runs.push_back (run);
+              jobs[w]->Push (job.str ());
+            }
+          working = working || busy[w] >= 0;
+        }
+      if (!working)
+        {
+          break;
+        }
+      if (!any)
+        {
+          usleep (1000);
+        }
+    }
+
+  for (uint32_t w = 0; w < workers; ++w)
+    {
+      if (pids[w] > 0)
+        {
+          jobs[w]->Push ("Q");
+          int status = 0;
+          waitpid (pids[w], &status, 0);
+          if (!WIFEXITED (status) || WEXITSTATUS (status) != 0) ++failed;
+        }
+      SweepQueue::Unmap (jobs[w]);
+      SweepQueue::Unmap (results[w]);
+    }
+  csvFile.close ();
+
+  uint32_t missing = runs.size () - completed;
+  double wallSec = std::chrono::duration<double> (std::chrono::steady_clock::now () - wallStart).count ();
+  std::cout << "✅ Sweep finished in " << std::fixed << std::setprecision (1) << wallSec << " s, "
+            << completed << " runs";
+  if (policy.IsAdaptive ())
+    {
+      uint32_t converged = std::count_if (state.begin (), state.end (), [] (const SweepScenarioState& s) {
+        return s.converged;
+      });
+      std::cout << " of at most " << scenarios.size () * policy.maxReplications << ", "
+                << converged << "/" << scenarios.size () << " scenarios within the CI targets";
+    }
+  if (failed > 0 || missing > 0)
+    std::cout << " (" << failed << " workers failed, " << missing << " runs without results)";
+  std::cout << "\n";
+  // Replications given up with their workers, or never re-run because no
+  // worker was left
+  for (uint32_t s = 0; s < state.size (); ++s)
+    {
+      uint32_t lost = state[s].lost + (state[s].converged ? 0 : state[s].retry.size ());
+      if (lost == 0)
+        {
+          continue;
+        }
+      if (aggregator.GetSummaries ().count (s) > 0)
+        {
+          aggregator.GetSummary (s).lostRuns = lost;
+        }
+      std::cout << "⚠️  Scenario " << s << ": " << lost << " replication(s) lost with their workers, "
+                << state[s].completed << " completed\n";
+    }
+  std::cout << "\n📊 Sweep CSV exported: " << output << "\n";
+
+  ExportSweepSummaryToCSV (aggregator.GetSummaries (), policy.IsAdaptive (), SweepSummaryPath (output));
+  PrintSweepSummary (aggregator.GetSummaries (), policy.IsAdaptive ());
+}
+
+// ===== Profiles and entry point =====
+
+// Run cfg without and with QoS marking on the same RngRun and report the
+// per-device latency gain
+inline int RunQosComparison (ScenarioConfig cfg)
+{
+  cfg.enableNetAnim = false;  // both runs would write the same XML
+  ScenarioConfig baselineCfg = cfg;
+  baselineCfg.qos = false;
+  ScenarioConfig qosCfg = cfg;
+  qosCfg.qos = true;
+
+  std::cout << "⚖️  QoS comparison: best effort vs EDCA (RngRun " << cfg.rngRun << ")\n";
+  ScenarioResult baseline = RunCachedScenario (baselineCfg);
+  ScenarioResult qos = RunCachedScenario (qosCfg);
+
+  if (WantsCsv (cfg))
+    {
+      ExportQosComparisonToCSV (baseline, qos, QosCompareCsvPath (cfg));
+    }
+  PrintQosComparison (baseline, qos);
+  return 0;
+}
+
+// Built-in starting points for the three programs; any option given on the
+// command line is applied on top of the selected profile.
+//   metrics  full Smart-OR, all three device classes (15 s)
+//   minimal  same four-node layout, robotic control traffic only (10 s)
+//   test     one vital-sign-like client on a "TestOR" BSS (10 s)
+//   surgical metrics layout with one-way sources: 1 kHz haptic control,
+//            1080p60 GOP video at 8 Mbps and 1 s vitals; robot control
+//            also runs downlink, measured separately
+inline void ApplyProfile (ScenarioConfig& cfg, const std::string& profile)
+{
+  if (profile == "metrics")
+    {
+      return;
+    }
+  if (profile == "minimal")
+    {
+      cfg.simulationTime = 10.0;
+      cfg.videoTraffic = false;
+      cfg.vitalTraffic = false;
+    }
+  else if (profile == "test")
+    {
+      cfg.simulationTime = 10.0;
+      cfg.ssid = "TestOR";
+      cfg.robotsPerRoom = 0;
+      cfg.endoscopesPerRoom = 0;
+      cfg.vitalsPerRoom = 1;
+      cfg.vitalMaxPackets = 10;
+      cfg.vitalStart = Seconds (2.0);
+    }
+  else if (profile == "surgical")
+    {
+      cfg.trafficModel = "surgical";
+      cfg.robotInterval = MilliSeconds (1);
+      cfg.robotPacketSize = 32;
+      cfg.robotMaxPackets = 2000;
+      cfg.videoInterval = MicroSeconds (16667);
+      cfg.videoMaxPackets = 5000;
+      cfg.robotDownlink = true;
+    }
+  else
+    {
+      NS_FATAL_ERROR ("Unknown profile " << profile << " (expected metrics, minimal, test or surgical)");
+    }
+}
+
+// Shared main: select the profile (--profile, else the scenario file's,
+// else defaultProfile), apply the --config scenario file and the other
+// options on top, then run it once or as a sweep
+inline int SurgicalMain (int argc, char *argv[], const std::string& defaultProfile)
+{
+  // MPI must be up before anything else touches the simulator
+  bool distributed = EnableDistributed (&argc, &argv);
+
+  // The profile and the scenario file set the defaults the other options
+  // override, so they are picked out of argv before the command line is parsed
+  std::string profile;
+  std::string configFile;
+  for (int i = 1; i < argc; ++i)
+    {
+      std::string arg = argv[i];
+      if (arg.compare (0, 10, "--profile=") == 0)
+        {
+          profile = arg.substr (10);
+        }
+      else if (arg.compare (0, 9, "--config=") == 0)
+        {
+          configFile = arg.substr (9);
+        }
+    }
+  std::vector<ScenarioFileEntry> configEntries;
+  if (!configFile.empty ())
+    {
+      configEntries = ReadScenarioFile (configFile);
+      if (profile.empty ())
+        {
+          profile = ScenarioFileProfile (configEntries);
+        }
+    }
+  if (profile.empty ())
+    {
+      profile = defaultProfile;
+    }
+  ScenarioConfig cfg;
+  ApplyProfile (cfg, profile);
+  ApplyScenarioFile (cfg, configEntries, configFile);
+  std::string sweepFile;
+  uint32_t workers = 0;
+  uint32_t replications = 1;
+  ReplicationPolicy adaptive;
+  adaptive.minReplications = 5;
+  adaptive.maxReplications = 100;
+  std::string sweepOutput = "surgical_sweep.csv";
+  bool qosCompare = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("profile", "Scenario profile: metrics, minimal, test or surgical", profile);
+  cmd.AddValue ("config", "JSON or YAML scenario file applied over the profile (sweep keys, see surgical-config.h)", configFile);
+  cmd.AddValue ("simulationTime", "Simulation time (seconds)", cfg.simulationTime);
+  cmd.AddValue ("enableNetAnim", "Enable NetAnim trace output", cfg.enableNetAnim);
+  cmd.AddValue ("netAnimStart", "NetAnim trace window start (s)", cfg.netAnimStart);
+  cmd.AddValue ("netAnimStop", "NetAnim trace window stop (s, 0 = end of run)", cfg.netAnimStop);
+  cmd.AddValue ("netAnimMetadataFraction", "Fraction of each second with packet metadata (0..1)", cfg.netAnimMetadataFraction);
+  cmd.AddValue ("netAnimMaxMb", "Stop NetAnim tracing once the XML reaches this size (MB)", cfg.netAnimMaxMb);
+  cmd.AddValue ("rooms", "Number of operating rooms, one edge-server AP each", cfg.rooms);
+  cmd.AddValue ("robotsPerRoom", "Robotic controllers per room", cfg.robotsPerRoom);
+  cmd.AddValue ("endoscopesPerRoom", "Endoscopes per room", cfg.endoscopesPerRoom);
+  cmd.AddValue ("vitalsPerRoom", "Vital-sign monitors per room", cfg.vitalsPerRoom);
+  cmd.AddValue ("roomSpacing", "Distance between neighbouring rooms (m)", cfg.roomSpacing);
+  cmd.AddValue ("channelPlan", "Room channels: shared (one channel) or orthogonal (one 20 MHz channel each)", cfg.channelPlan);
+  cmd.AddValue ("serverTier", "Where servers run: edge (room AP), fog or cloud (over a wired backbone)", cfg.serverTier);
+  cmd.AddValue ("fogLinkRate", "AP-fog link rate", cfg.fogLinkRate);
+  cmd.AddValue ("fogLinkDelay", "AP-fog link delay", cfg.fogLinkDelay);
+  cmd.AddValue ("cloudLinkRate", "Fog-cloud link rate", cfg.cloudLinkRate);
+  cmd.AddValue ("cloudLinkDelay", "Fog-cloud link delay", cfg.cloudLinkDelay);
+  cmd.AddValue ("cloudLinkLossPercent", "Fog-cloud packet loss per direction (%)", cfg.cloudLinkLossPercent);
+  cmd.AddValue ("mobility", "Device mobility: static, waypoint or scripted", cfg.mobility);
+  cmd.AddValue ("mobileClasses", "Classes that walk with mobility=waypoint, e.g. vital,video or all", cfg.mobileClasses);
+  cmd.AddValue ("trajectoryFile", "CSV device,time_s,x_m,y_m for mobility=scripted", cfg.trajectoryFile);
+  cmd.AddValue ("mobilitySpeed", "Top walking speed of devices and obstacles (m/s)", cfg.mobilitySpeed);
+  cmd.AddValue ("mobilityPause", "Pause at every random waypoint", cfg.mobilityPause);
+  cmd.AddValue ("obstaclesPerRoom", "Moving people/carts per room shadowing the links they cross", cfg.obstaclesPerRoom);
+  cmd.AddValue ("obstacleLossDb", "Loss per obstacle on a link's line of sight (dB)", cfg.obstacleLossDb);
+  cmd.AddValue ("obstacleRadius", "Obstacle radius (m)", cfg.obstacleRadius);
+  cmd.AddValue ("mobilityUpdateInterval", "Granularity of obstacle and NetAnim position updates", cfg.mobilityUpdateInterval);
+  cmd.AddValue ("positionCell", "Cell size of the latency-by-position report (m)", cfg.positionCell);
+  cmd.AddValue ("sweep", "Scenario list file (key=v1,v2 tokens expand into a grid)", sweepFile);
+  cmd.AddValue ("workers", "Sweep worker processes (0 = one per online CPU)", workers);
+  cmd.AddValue ("replications", "Runs per sweep scenario, each with its own RngRun", replications);
+  cmd.AddValue ("ciP99Ms", "Replicate until the 95% CI of robot p99 latency is within +/- this (ms, 0 = off)", adaptive.ciP99Ms);
+  cmd.AddValue ("ciSuccessPercent", "Replicate until the 95% CI of robot task success is within +/- this (%, 0 = off)", adaptive.ciSuccessPercent);
+  cmd.AddValue ("minReplications", "With a CI target, runs per scenario before convergence is checked", adaptive.minReplications);
+  cmd.AddValue ("maxReplications", "With a CI target, give up on a scenario after this many runs", adaptive.maxReplications);
+  cmd.AddValue ("sweepOutput", "Merged sweep results CSV", sweepOutput);
+  cmd.AddValue ("outputFormat", "Result files: csv, binary (.npy columns) or both", cfg.outputFormat);
+  cmd.AddValue ("runId", "Run identifier used in result file names", cfg.runId);
+  cmd.AddValue ("resultCache", "Directory of cached results: a scenario simulated before is read back, not re-run", cfg.resultCache);
+  cmd.AddValue ("windowInterval", "Per-device time-series window, e.g. 1s (0 = off)", cfg.windowInterval);
+  cmd.AddValue ("telemetryUdp", "Stream live per-device windows as JSON datagrams to host:port (needs windowInterval)", cfg.telemetryUdp);
+  cmd.AddValue ("telemetryHttpPort", "Serve live per-device windows as Prometheus gauges on this port (0 = off)", cfg.telemetryHttpPort);
+  cmd.AddValue ("telemetryInterval", "Wall-clock seconds between live telemetry updates", cfg.telemetryInterval);
+  cmd.AddValue ("telemetryPoll", "Simulated time between checks of the telemetry wall clock", cfg.telemetryPoll);
+  cmd.AddValue ("packetTrace", "Append a binary record of every packet sent and received", cfg.packetTrace);
+  cmd.AddValue ("packetTraceArenaKb", "With --packetTrace, in-memory buffer the writer thread drains (KiB)", cfg.packetTraceArenaKb);
+  cmd.AddValue ("warmStart", "Skip settling: static ARP, active probing, traffic from warmStartSettle", cfg.warmStart);
+  cmd.AddValue ("warmStartSettle", "With --warmStart, when the first class starts sending", cfg.warmStartSettle);
+  cmd.AddValue ("distributed", "Run under MPI (mpirun -np N), rooms partitioned across ranks", distributed);
+  cmd.AddValue ("profiling", "Time a sample of events per source and write a JSON profile", cfg.profiling);
+  cmd.AddValue ("profileSampleEvery", "With --profiling, time one in this many events", cfg.profileSampleEvery);
+  cmd.AddValue ("realtime", "Run in real time (RealtimeSimulatorImpl) and report how far it falls behind", cfg.realtime);
+  cmd.AddValue ("realtimeSync", "With --realtime, BestEffort or HardLimit (abort past realtimeHardLimit)", cfg.realtimeSync);
+  cmd.AddValue ("realtimeHardLimit", "With realtimeSync=HardLimit, lag at which the run aborts", cfg.realtimeHardLimit);
+  cmd.AddValue ("realtimeProbe", "With --realtime, simulated time between lag probes", cfg.realtimeProbe);
+  cmd.AddValue ("realtimeLagBudgetMs", "With --realtime, p99 lag up to which the run keeps up (ms)", cfg.realtimeLagBudgetMs);
+  cmd.AddValue ("tapStations", "Emulated stations in room 1 backed by host taps <tapPrefix>sta<k> (needs --realtime)", cfg.tapStations);
+  cmd.AddValue ("tapEdge", "Bridge a wired port of room 1's AP to the existing host tap <tapPrefix>edge (needs --realtime)", cfg.tapEdge);
+  cmd.AddValue ("tapPrefix", "Prefix of the host tap device names", cfg.tapPrefix);
+  cmd.AddValue ("tapEdgeAddress", "With --tapEdge, address of the AP on the host bridge", cfg.tapEdgeAddress);
+  cmd.AddValue ("tapEdgeMask", "With --tapEdge, mask of the host bridge's subnet", cfg.tapEdgeMask);
+  cmd.AddValue ("trafficModel", "Traffic: echo (UdpEcho streams) or surgical (one-way sources)", cfg.trafficModel);
+  cmd.AddValue ("robotDownlink", "Also stream robot control from the edge server (surgical traffic)", cfg.robotDownlink);
+  cmd.AddValue ("videoDownlink", "Also stream video from the edge server (surgical traffic)", cfg.videoDownlink);
+  cmd.AddValue ("vitalDownlink", "Also stream vitals from the edge server (surgical traffic)", cfg.vitalDownlink);
+  cmd.AddValue ("txPowerDbm", "Transmit power of every AP and station (dBm)", cfg.txPowerDbm);
+  cmd.AddValue ("dataMode", "ConstantRateWifiManager data mode, e.g. HeMcs7 (empty = its default)", cfg.dataMode);
+  cmd.AddValue ("fidelity", "Wi-Fi model: fast (unit disk, hundreds of stations), default or high (spectrum, walls, MinstrelHt)", cfg.fidelity);
+  cmd.AddValue ("rateControl", "Rate manager override: constant, minstrel or ideal", cfg.rateControl);
+  cmd.AddValue ("fastRange", "With fidelity=fast, reception range (m)", cfg.fastRange);
+  cmd.AddValue ("wallLossDb", "With fidelity=high, loss per room wall crossed (dB)", cfg.wallLossDb);
+  cmd.AddValue ("batteryClasses", "Battery-powered classes with a radio energy model, e.g. vital,video or all", cfg.batteryClasses);
+  cmd.AddValue ("batteryEnergyJ", "Energy of a full battery (J; 13320 = 1000 mAh at 3.7 V)", cfg.batteryEnergyJ);
+  cmd.AddValue ("batteryVoltage", "Battery supply voltage (V)", cfg.batteryVoltage);
+  cmd.AddValue ("powerSave", "Battery stations: off, psm (802.11 power save) or twt (emulated Target Wake Time)", cfg.powerSave);
+  cmd.AddValue ("twtInterval", "With powerSave=twt, time between service periods", cfg.twtInterval);
+  cmd.AddValue ("twtWakeDuration", "With powerSave=twt, awake time per service period", cfg.twtWakeDuration);
+  cmd.AddValue ("neighbourBss", "Foreign co-channel BSSs per room (adjacent ORs, hospital Wi-Fi)", cfg.neighbourBss);
+  cmd.AddValue ("backgroundStations", "Stations loading each neighbour BSS", cfg.backgroundStations);
+  cmd.AddValue ("backgroundTraffic", "Neighbour BSS load: onoff (UDP at backgroundRateMbps), bulk (TCP) or none", cfg.backgroundTraffic);
+  cmd.AddValue ("backgroundRateMbps", "With backgroundTraffic=onoff, offered load per background station (Mbps)", cfg.backgroundRateMbps);
+  cmd.AddValue ("neighbourDistance", "Distance from a room's AP to its neighbour APs (m)", cfg.neighbourDistance);
+  cmd.AddValue ("bssColoring", "HE BSS colours: none or distinct (one per BSS)", cfg.bssColoring);
+  cmd.AddValue ("obssPdLevel", "OBSS PD spatial reuse threshold (dBm, 0 = off; needs bssColoring=distinct)", cfg.obssPdLevel);
+  cmd.AddValue ("qos", "Mark flows so robot/video/vitals use AC_VO/AC_VI/AC_BE", cfg.qos);
+  cmd.AddValue ("qosCompare", "Run best effort and QoS back to back and report the latency gain", qosCompare);
+  cmd.AddValue ("safetyStop", "Stop a run as soon as robotic control is conclusively unsafe", cfg.safetyStop);
+  cmd.AddValue ("safetyCheckInterval", "How often the safety watchdog checks, e.g. 100ms", cfg.safetyCheckInterval);
+  cmd.AddValue ("safetyLatencyMs", "Robotic control p99 latency limit (ms)", cfg.safetyLatencyMs);
+  cmd.AddValue ("safetyTaskSec", "Robotic control task completion limit (s)", cfg.safetyTaskSec);
+  cmd.Parse (argc, argv);
+
+  if (!WantsCsv (cfg) && !WantsBinary (cfg))
+    {
+      NS_FATAL_ERROR ("outputFormat must be csv, binary or both, not " << cfg.outputFormat);
+    }
+
+  // --RngRun is the run number of a single simulation and the first one of a sweep
+  cfg.rngRun = RngSeedManager::GetRun ();
+  cfg.attributeOverrides = AttributeOverrides (argc, argv);
+  if (!cfg.resultCache.empty () && !cfg.attributeOverrides.empty ())
+    {
+      std::cout << "♻️  Result cache keyed on " << cfg.attributeOverrides.size ()
+                << " ns-3 attribute override(s) as well as the scenario\n";
+    }
+  cfg.distributed = distributed;
+  if (distributed && (qosCompare || !sweepFile.empty () || adaptive.IsAdaptive () || WantsBinary (cfg)))
+    {
+      NS_FATAL_ERROR ("--distributed runs a single scenario with outputFormat=csv");
+    }
+
+  if (qosCompare && sweepFile.empty ())
+    {
+      return RunQosComparison (cfg);
+    }
+
+  if (sweepFile.empty () && !adaptive.IsAdaptive ())
+    {
+      std::unique_ptr<BinaryResults> binary;
+      if (WantsBinary (cfg))
+        {
+          binary.reset (new BinaryResults (BinaryResultsDir (cfg)));
+        }
+      ScenarioResult result = RunCachedScenario (cfg, binary.get ());
+      if (result.systemId != 0)
+        {
+          // Only rank 0 holds the gathered metrics
+          DisableDistributed (distributed);
+          return 0;
+        }
+      std::map<std::string, uint32_t> taskTargets = BuildTaskTargets (cfg);
+
+      // ========== 10. Export to CSV ==========
+      if (WantsCsv (cfg))
+        {
+          ExportMetricsToCSV (result.devices, taskTargets, MetricsCsvPath (cfg));
+          if (!result.positions.empty ())
+            {
+              ExportPositionLatencyToCSV (result.positions, PositionsCsvPath (cfg));
+            }
+        }
+      if (binary)
+        {
+          ExportMetricsToBinary (result.devices, taskTargets, cfg.rngRun, *binary);
+          std::cout << "\n📦 Binary results appended: " << binary->dir << "\n";
+        }
+      if (result.profile.enabled)
+        {
+          ExportProfileToJSON (result, cfg, ProfileJsonPath (cfg));
+        }
+      PrintResults (result, taskTargets, cfg);
+      DisableDistributed (distributed);
+      return 0;
+    }
+
+  // All shards of one sweep share a results directory
+  if (cfg.runId.empty ())
+    {
+      cfg.runId = "sweep" + std::to_string (cfg.rngRun);
+    }
+
+  ScenarioConfig base = cfg;
+  base.enableNetAnim = false;  // One XML per worker would be useless and slow
+  // A CI target without a sweep file replicates the one scenario given
+  std::vector<ScenarioConfig> scenarios = sweepFile.empty () ? std::vector<ScenarioConfig> {base}
+                                                             : LoadSweepFile (sweepFile, base);
+  if (scenarios.empty ())
+    {
+      NS_FATAL_ERROR ("Sweep file " << sweepFile << " lists no scenarios");
+    }
+  for (const auto& scenario : scenarios)
+    {
+      if ((scenario.tapStations > 0 || scenario.tapEdge) && workers != 1)
+        {
+          // Concurrent workers would all claim the same host taps
+          NS_FATAL_ERROR ("tapStations and tapEdge need --workers=1 in a sweep");
+        }
+    }
+
+  ReplicationPolicy policy;
+  policy.minReplications = policy.maxReplications = replications;
+  if (adaptive.IsAdaptive ())
+    {
+      NS_ABORT_MSG_IF (adaptive.minReplications < 2 || adaptive.minReplications > adaptive.maxReplications,
+                       "need 2 <= minReplications <= maxReplications");
+      policy = adaptive;
+    }
+  NS_ABORT_MSG_IF (policy.maxReplications == 0, "replications must be positive");
+
+  RunSweep (scenarios, policy, workers, cfg.rngRun, sweepOutput);
+  return 0;
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_DRIVER_H */
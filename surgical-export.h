@@ -0,0 +1,566 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * CSV, binary and terminal reports of a finished scenario
+ */
+
+#ifndef SURGICAL_EXPORT_H
+#define SURGICAL_EXPORT_H
+
+#include "surgical-scenario.h"
+#include "surgical-aggregator.h"
+#include "surgical-cache.h"
+
+namespace ns3 {
+
+// Latency per device, direction and position cell; cells are in metres
+// relative to the device's room origin
+inline void ExportPositionLatencyToCSV (const std::vector<PositionMetrics>& positions,
+                                        const std::string& path)
+{
+  std::ofstream csvFile (path);
+  if (!csvFile.is_open ())
+    {
+      NS_LOG_ERROR ("Failed to open " << path << " for writing");
+      return;
+    }
+  csvFile << std::fixed << std::setprecision (6);
+  csvFile << "Device,Direction,CellX,CellY,RxPackets,P50LatencyMs,P99LatencyMs,MaxLatencyMs\n";
+  for (const auto& p : positions)
+    {
+      csvFile << p.name << "," << DirectionLabel (p.direction) << ","
+              << p.cellX << "," << p.cellY << "," << p.latency.GetCount () << ","
+              << p.latency.GetQuantileMs (0.50) << "," << p.latency.GetQuantileMs (0.99) << ","
+              << p.latency.GetMax () / 1e6 << "\n";
+    }
+}
+
+// ===== Event-loop profile =====
+// Sampled wall time per event source is scaled by SampleEvery to estimate
+// its share of the whole run; sources below 0.1% are left out of the table.
+
+inline double WallPerSimulatedSecond (const ScenarioResult& result)
+{
+  return (result.simulatedSeconds > 0) ? result.wallSeconds / result.simulatedSeconds : 0.0;
+}
+
+inline std::string JsonString (const std::string& text)
+{
+  std::string quoted = "\"";
+  for (char c : text)
+    {
+      if (c == '"' || c == '\\')
+        {
+          quoted += '\\';
+        }
+      quoted += c;
+    }
+  return quoted + "\"";
+}
+
+inline void ExportProfileToJSON (const ScenarioResult& result, const ScenarioConfig& cfg,
+                                 const std::string& path)
+{
+  std::ofstream json (path);
+  if (!json.is_open ())
+    {
+      NS_LOG_ERROR ("Failed to open " << path << " for writing");
+      return;
+    }
+
+  const EventProfile& p = result.profile;
+  json << std::setprecision (std::numeric_limits<double>::max_digits10);
+  json << "{\n"
+       << "  \"runId\": " << JsonString (cfg.runId) << ",\n"
+       << "  \"rngRun\": " << cfg.rngRun << ",\n"
+       << "  \"trafficModel\": " << JsonString (cfg.trafficModel) << ",\n"
+       << "  \"rooms\": " << cfg.rooms << ",\n"
+       << "  \"stations\": " << result.stations << ",\n"
+       << "  \"simulationTime\": " << cfg.simulationTime << ",\n"
+       << "  \"simulatedSeconds\": " << result.simulatedSeconds << ",\n"
+       << "  \"wallSeconds\": " << result.wallSeconds << ",\n"
+       << "  \"wallPerSimulatedSecond\": " << WallPerSimulatedSecond (result) << ",\n"
+       << "  \"events\": " << result.events << ",\n"
+       << "  \"eventsPerSecond\": " << (result.wallSeconds > 0 ? result.events / result.wallSeconds : 0.0) << ",\n"
+       << "  \"peakRssMb\": " << result.peakRssMb << ",\n"
+       << "  \"sampleEvery\": " << p.sampleEvery << ",\n"
+       << "  \"sampledEvents\": " << p.sampledEvents << ",\n"
+       << "  \"sampledWallSeconds\": " << p.sampledWallSeconds << ",\n"
+       << "  \"sources\": [";
+  for (uint32_t i = 0; i < p.sources.size (); ++i)
+    {
+      const EventSourceCost& c = p.sources[i];
+      json << (i ? "," : "") << "\n    {\"source\": " << JsonString (c.source)
+           << ", \"sampledEvents\": " << c.sampledEvents
+           << ", \"sampledWallSeconds\": " << c.sampledWallSeconds
+           << ", \"share\": " << (p.sampledWallSeconds > 0 ? c.sampledWallSeconds / p.sampledWallSeconds : 0.0)
+           << "}";
+    }
+  json << "\n  ]\n}\n";
+  std::cout << "\n⏱️  Event profile exported: " << path << "\n";
+}
+
+inline void PrintEventProfile (const ScenarioResult& result)
+{
+  const EventProfile& p = result.profile;
+  std::cout << "\n⏱️  Event-loop profile: " << std::setprecision (3) << WallPerSimulatedSecond (result)
+            << " s wall per simulated s, " << p.sampledEvents << " events sampled (1 in " << p.sampleEvery << ")\n";
+  std::cout << "   " << std::left << std::setw(36) << "Event source" << std::right
+            << std::setw(10) << "Sampled" << std::setw(12) << "Est. wall s" << std::setw(9) << "Share\n";
+  for (const auto& c : p.sources)
+    {
+      double share = (p.sampledWallSeconds > 0) ? c.sampledWallSeconds / p.sampledWallSeconds : 0.0;
+      if (share < 0.001)
+        {
+          continue;
+        }
+      std::cout << "   " << std::left << std::setw(36) << c.source.substr (0, 35) << std::right
+                << std::setw(10) << c.sampledEvents
+                << std::setw(12) << std::setprecision (3) << c.sampledWallSeconds * p.sampleEvery
+                << std::setw(7) << std::setprecision (1) << share * 100.0 << " %\n";
+    }
+}
+
+// Function to export metrics to CSV (now safe - struct is fully defined)
+inline void ExportMetricsToCSV (const std::vector<DeviceMetrics>& results,
+                                const std::map<std::string, uint32_t>& taskTargets,
+                                const std::string& path)
+{
+  std::ofstream csvFile (path);
+  if (!csvFile.is_open ())
+    {
+      NS_LOG_ERROR ("Failed to open " << path << " for writing");
+      return;
+    }
+
+  // Latencies are in ms with 6 decimals, i.e. nanosecond resolution
+  csvFile << std::fixed << std::setprecision (6);
+
+  // CSV header
+  csvFile << "Device,TxPackets,RxPackets,LossPercent,AvgLatencyMs,AvgJitterMs,"
+          << "TaskTargetPackets,TaskCompleted,TaskCompletionTimeSec,SuccessRatePercent,"
+          << "P50LatencyMs,P99LatencyMs,P999LatencyMs,MaxLatencyMs,Direction,EnergyJ,BatteryLifeHours\n";
+
+  // CSV rows
+  for (const auto& r : results)
+    {
+      std::string completed = r.taskCompleted ? "Yes" : "No";
+      double successRate = (taskTargets.at(r.name) > 0) ? 
+        (double)r.rxPackets / taskTargets.at(r.name) * 100.0 : 0.0;
+
+      csvFile << r.name << ","
+              << r.txPackets << ","
+              << r.rxPackets << ","
+              << r.lossRate << ","
+              << r.avgLatencyMs << ","
+              << r.avgJitterMs << ","
+              << taskTargets.at(r.name) << ","
+              << completed << ","
+              << r.taskCompletionTime << ","
+              << successRate << ","
+              << r.latency.GetQuantileMs (0.50) << ","
+              << r.latency.GetQuantileMs (0.99) << ","
+              << r.latency.GetQuantileMs (0.999) << ","
+              << r.latency.GetMax () / 1e6 << ","
+              << DirectionLabel (r.direction) << ","
+              << r.energyJ << ","
+              << r.batteryLifeHours << "\n";
+    }
+
+  csvFile.close ();
+  std::cout << "\n📊 CSV exported: " << path << "\n";
+}
+
+inline void ExportMetricsToBinary (const std::vector<DeviceMetrics>& results,
+                                   const std::map<std::string, uint32_t>& taskTargets,
+                                   uint32_t rngRun, BinaryResults& out)
+{
+  ColumnarTable& t = out.devices;
+  for (const auto& r : results)
+    {
+      t.Put<uint32_t> (DC_RUN, rngRun);
+      t.PutString (DC_DEVICE, r.name);
+      t.Put<uint8_t> (DC_CLASS, r.deviceClass);
+      t.Put<uint32_t> (DC_ROOM, r.room);
+      t.Put<uint32_t> (DC_TX_PACKETS, r.txPackets);
+      t.Put<uint32_t> (DC_RX_PACKETS, r.rxPackets);
+      t.Put<double> (DC_LOSS_PCT, r.lossRate);
+      t.Put<double> (DC_AVG_LATENCY_MS, r.avgLatencyMs);
+      t.Put<double> (DC_AVG_JITTER_MS, r.avgJitterMs);
+      t.Put<double> (DC_P50_LATENCY_MS, r.latency.GetQuantileMs (0.50));
+      t.Put<double> (DC_P99_LATENCY_MS, r.latency.GetQuantileMs (0.99));
+      t.Put<double> (DC_P999_LATENCY_MS, r.latency.GetQuantileMs (0.999));
+      t.Put<double> (DC_MAX_LATENCY_MS, r.latency.GetMax () / 1e6);
+      t.Put<uint32_t> (DC_TASK_TARGET, taskTargets.at (r.name));
+      t.Put<uint8_t> (DC_TASK_COMPLETED, r.taskCompleted);
+      t.Put<double> (DC_TASK_TIME_S, r.taskCompletionTime);
+      t.Put<uint8_t> (DC_DIRECTION, r.direction);
+      t.Put<double> (DC_ENERGY_J, r.energyJ);
+      t.Put<double> (DC_BATTERY_LIFE_H, r.batteryLifeHours);
+      t.EndRow ();
+    }
+  t.Flush ();
+  out.packets.Flush ();
+  out.windows.Flush ();
+}
+
+inline void PrintResults (const ScenarioResult& result,
+                          const std::map<std::string, uint32_t>& taskTargets,
+                          const ScenarioConfig& cfg)
+{
+  const std::vector<DeviceMetrics>& results = result.devices;
+
+  // ========== 11. Output Results to Terminal ==========
+  std::cout << "\n";
+  std::cout << "╔════════════════════════════════════════════════════════════════════════════════╗\n";
+  std::cout << "║        SURGICAL IOMT NETWORK METRICS - LATENCY & TASK COMPLETION            ║\n";
+  std::cout << "╚════════════════════════════════════════════════════════════════════════════════╝\n";
+  std::cout << "\n";
+
+  // Latency/Jitter/Loss Table
+  std::cout << "┌──────────────┬──────────┬──────────┬──────────┬──────────┬──────────┐\n";
+  std::cout << "│ Device       │ Tx Pkts  │ Rx Pkts  │ Loss (%) │ Latency  │ Jitter   │\n";
+  std::cout << "│              │          │          │          │ (ms)     │ (ms)     │\n";
+  std::cout << "├──────────────┼──────────┼──────────┼──────────┼──────────┼──────────┤\n";
+  for (auto& r : results)
+    {
+      std::cout << "│ " << std::left << std::setw(12) << DisplayName (r)
+                << " │ " << std::right << std::setw(8) << r.txPackets
+                << " │ " << std::setw(8) << r.rxPackets
+                << " │ " << std::setw(8) << std::fixed << std::setprecision(2) << r.lossRate
+                << " │ " << std::setw(8) << std::fixed << std::setprecision(3) << r.avgLatencyMs
+                << " │ " << std::setw(8) << std::fixed << std::setprecision(3) << r.avgJitterMs
+                << " │\n";
+    }
+  std::cout << "└──────────────┴──────────┴──────────┴──────────┴──────────┴──────────┘\n";
+
+  // Latency Percentile Table
+  std::cout << "\n";
+  std::cout << "┌──────────────┬──────────┬──────────┬──────────┬──────────┐\n";
+  std::cout << "│ Device       │ p50      │ p99      │ p99.9    │ Max      │\n";
+  std::cout << "│              │ (ms)     │ (ms)     │ (ms)     │ (ms)     │\n";
+  std::cout << "├──────────────┼──────────┼──────────┼──────────┼──────────┤\n";
+  for (auto& r : results)
+    {
+      std::cout << "│ " << std::left << std::setw(12) << DisplayName (r)
+                << " │ " << std::right << std::setw(8) << std::fixed << std::setprecision(3) << r.latency.GetQuantileMs (0.50)
+                << " │ " << std::setw(8) << r.latency.GetQuantileMs (0.99)
+                << " │ " << std::setw(8) << r.latency.GetQuantileMs (0.999)
+                << " │ " << std::setw(8) << r.latency.GetMax () / 1e6
+                << " │\n";
+    }
+  std::cout << "└──────────────┴──────────┴──────────┴──────────┴──────────┘\n";
+
+  // Task Completion Table
+  std::cout << "\n";
+  std::cout << "┌──────────────┬──────────────┬──────────────┬──────────────┬──────────────┐\n";
+  std::cout << "│ Device       │ Task Target  │ Completed?   │ Completion   │ Success      │\n";
+  std::cout << "│              │ (packets)    │              │ Time (s)     │ Rate (%)     │\n";
+  std::cout << "├──────────────┼──────────────┼──────────────┼──────────────┼──────────────┤\n";
+  for (auto& r : results)
+    {
+      std::string status = r.taskCompleted ? "✅ Yes" : (r.rxPackets > 0 ? "⚠️ Partial" : "❌ No");
+      double successRate = (taskTargets.at(r.name) > 0) ? 
+        (double)r.rxPackets / taskTargets.at(r.name) * 100.0 : 0.0;
+
+      std::cout << "│ " << std::left << std::setw(12) << DisplayName (r)
+                << " │ " << std::right << std::setw(12) << taskTargets.at(r.name)
+                << " │ " << std::setw(12) << status
+                << " │ " << std::setw(12) << std::fixed << std::setprecision(3) << r.taskCompletionTime
+                << " │ " << std::setw(12) << std::fixed << std::setprecision(1) << successRate
+                << " │\n";
+    }
+  std::cout << "└──────────────┴──────────────┴──────────────┴──────────────┴──────────────┘\n";
+
+  // Battery Table: what power save costs in latency and buys in battery life
+  if (!cfg.batteryClasses.empty ())
+    {
+      std::cout << "\n";
+      std::cout << "Battery stations, power save " << cfg.powerSave << ":\n";
+      std::cout << "┌──────────────┬──────────┬──────────┬──────────┬──────────┐\n";
+      std::cout << "│ Device       │ p99 UL   │ Energy   │ Power    │ Battery  │\n";
+      std::cout << "│              │ (ms)     │ (J)      │ (mW)     │ (h)      │\n";
+      std::cout << "├──────────────┼──────────┼──────────┼──────────┼──────────┤\n";
+      std::map<DeviceClass, std::pair<double, double>> worst;  // by class: highest p99, shortest life
+      for (auto& r : results)
+        {
+          // One line per radio: the energy is on the uplink row
+          if (!IsBatteryClass (cfg, r.deviceClass) || r.direction != UPLINK)
+            {
+              continue;
+            }
+          double powerMw = (result.simulatedSeconds > 0) ? r.energyJ / result.simulatedSeconds * 1000.0 : 0.0;
+          std::cout << "│ " << std::left << std::setw(12) << DisplayName (r)
+                    << " │ " << std::right << std::setw(8) << std::fixed << std::setprecision(3) << r.latency.GetQuantileMs (0.99)
+                    << " │ " << std::setw(8) << std::setprecision(3) << r.energyJ
+                    << " │ " << std::setw(8) << std::setprecision(1) << powerMw
+                    << " │ " << std::setw(8) << std::setprecision(1) << r.batteryLifeHours
+                    << " │\n";
+          auto w = worst.emplace (r.deviceClass, std::make_pair (0.0, std::numeric_limits<double>::infinity ())).first;
+          w->second.first = std::max (w->second.first, r.latency.GetQuantileMs (0.99));
+          w->second.second = std::min (w->second.second, r.batteryLifeHours);
+        }
+      std::cout << "└──────────────┴──────────┴──────────┴──────────┴──────────┘\n";
+      for (const auto& w : worst)
+        {
+          std::cout << "   " << g_deviceClasses[w.first].label << ": p99 up to " << std::setprecision (3)
+                    << w.second.first << " ms, battery life from " << std::setprecision (1) << w.second.second << " h\n";
+        }
+    }
+
+  // Surgical Safety Assessment
+  std::cout << "\n";
+  std::cout << "┌──────────────────────────────────────────────────────────────────────────────┐\n";
+  std::cout << "│ SURGICAL SAFETY ASSESSMENT                                                   │\n";
+  std::cout << "├──────────────────────────────────────────────────────────────────────────────┤\n";
+
+  bool allSafe = true;
+  std::cout << std::setprecision (3);
+  for (auto& r : results)
+    {
+      if (r.deviceClass == ROBOT_CTRL)
+        {
+          // Judge the tail, not the mean: one late control packet is enough to hurt
+          double p99LatencyMs = r.latency.GetQuantileMs (0.99);
+          bool latencySafe = (r.latency.GetCount () > 0 && p99LatencyMs < cfg.safetyLatencyMs);
+          bool timeSafe = (r.taskCompletionTime < cfg.safetyTaskSec && r.taskCompleted);
+          
+          if (latencySafe && timeSafe)
+            std::cout << "│ ✅ ROBOTIC CONTROL: p99 Latency=" << p99LatencyMs << "ms (<" << cfg.safetyLatencyMs << "ms), Task=" 
+                      << r.taskCompletionTime << "s (<" << cfg.safetyTaskSec << "s) → SAFE FOR SURGERY      │\n";
+          else
+            {
+              allSafe = false;
+              std::cout << "│ ⚠️  ROBOTIC CONTROL: SAFETY THRESHOLDS EXCEEDED                           │\n";
+              if (!latencySafe) std::cout << "│    → p99 Latency " << p99LatencyMs << "ms > " << cfg.safetyLatencyMs << "ms surgical limit            │\n";
+              if (!timeSafe) std::cout << "│    → Task time " << r.taskCompletionTime << "s > " << cfg.safetyTaskSec << "s or incomplete           │\n";
+            }
+        }
+    }
+  if (result.safety.stopped)
+    {
+      allSafe = false;
+      std::cout << "│ ⛔ WATCHDOG STOP at " << result.safety.time.GetSeconds () << "s: " << result.safety.device
+                << " → " << result.safety.cause << "\n";
+    }
+  if (allSafe)
+    std::cout << "│                                                                              │\n";
+  std::cout << "└──────────────────────────────────────────────────────────────────────────────┘\n";
+
+  // Simulator cost, to see where large topologies stop scaling
+  std::cout << "\n⚙️  Simulated " << std::setprecision (3) << result.simulatedSeconds << " s, " << result.stations << " stations in " << cfg.rooms << " room(s): "
+            << result.events << " events in " << std::setprecision (2) << result.wallSeconds << " s wall ("
+            << std::setprecision (0) << (result.wallSeconds > 0 ? result.events / result.wallSeconds : 0.0)
+            << " events/s), peak RSS " << std::setprecision (1) << result.peakRssMb << " MB\n";
+  if (result.cached)
+    std::cout << "   ♻️  Read from the result cache " << ResultCachePath (cfg) << " (cost above is the original run's)\n";
+  std::cout << "   Servers on the " << cfg.serverTier << " tier, " << cfg.channelPlan << " room channels, "
+            << cfg.fidelity << " fidelity Wi-Fi with " << RateControl (cfg) << " rate control";
+  if (cfg.distributed)
+    std::cout << ", " << DistributedSize () << " MPI ranks (events summed over ranks, wall time of rank 0)";
+  std::cout << "\n";
+  if (cfg.neighbourBss > 0)
+    {
+      std::cout << "   " << cfg.neighbourBss << " co-channel neighbour BSS(s) per room with " << cfg.backgroundStations
+                << " station(s) each, " << cfg.backgroundTraffic << " background load";
+      if (cfg.backgroundTraffic != "none")
+        std::cout << ": " << std::setprecision (1) << result.backgroundMbps << " Mbps delivered"
+                  << (cfg.distributed ? " on rank 0" : "");
+      std::cout << "; BSS colouring " << cfg.bssColoring;
+      if (cfg.obssPdLevel != 0)
+        std::cout << ", OBSS PD " << cfg.obssPdLevel << " dBm";
+      std::cout << "\n";
+    }
+  std::cout << "   " << std::min<uint32_t> (result.associations, result.stations) << "/" << result.stations
+            << " stations associated, the last at " << std::setprecision (3) << result.lastAssociationSeconds << " s"
+            << (cfg.warmStart ? " (warm start)" : "") << "\n";
+  if (result.realtime.enabled)
+    {
+      const RealtimeLagReport& rt = result.realtime;
+      std::cout << "   Real time (" << cfg.realtimeSync << "): lag p50 " << std::setprecision (3)
+                << rt.lag.GetQuantileMs (0.50) << " ms, p99 " << rt.lag.GetQuantileMs (0.99) << " ms, max "
+                << rt.lag.GetMax () / 1e6 << " ms, jitter " << rt.jitterMs << " ms, " << std::setprecision (1)
+                << rt.LatePercent () << "% of " << rt.probes << " probes over " << rt.budgetMs << " ms → "
+                << (rt.KeptUp () ? "KEPT UP" : "FALLS BEHIND (shrink the scenario)") << "\n";
+      if (cfg.tapStations > 0 || cfg.tapEdge)
+        std::cout << "   Emulation bridge: " << cfg.tapStations << " tap station(s)"
+                  << (cfg.tapEdge ? ", AP wired to " + cfg.tapPrefix + "edge at " + cfg.tapEdgeAddress : std::string ())
+                  << "\n";
+    }
+
+  if (result.profile.enabled)
+    {
+      PrintEventProfile (result);
+    }
+
+  std::cout << "\n📁 Files generated:\n";
+  if (WantsCsv (cfg))
+    std::cout << "   • " << std::left << std::setw(28) << MetricsCsvPath (cfg) << " (for analysis in Excel/Python)\n" << std::right;
+  if (WantsCsv (cfg) && cfg.windowInterval.IsStrictlyPositive ())
+    std::cout << "   • " << std::left << std::setw(28) << WindowsCsvPath (cfg) << " (per-window time series)\n" << std::right;
+  if (WantsBinary (cfg))
+    std::cout << "   • " << BinaryResultsDir (cfg) << "/{devices,packets,windows}/*.npy (memory-mappable columns)\n";
+  if (WantsCsv (cfg) && !result.positions.empty ())
+    std::cout << "   • " << std::left << std::setw(28) << PositionsCsvPath (cfg) << " (latency by position)\n" << std::right;
+  if (cfg.packetTrace)
+    std::cout << "   • " << std::left << std::setw(28) << PacketTracePath (cfg) << std::right << " (per-packet trace, "
+              << result.traceRecords << " records, " << result.traceStalls << " writer stalls)\n";
+  if (result.profile.enabled)
+    std::cout << "   • " << std::left << std::setw(28) << ProfileJsonPath (cfg) << " (event-loop profile)\n" << std::right;
+  if (cfg.enableNetAnim)
+    std::cout << "   • surgical-iomt-metrics.xml   (open with NetAnim)\n";
+  std::cout << "\n💡 Quick analysis tip:\n";
+  if (WantsCsv (cfg))
+    std::cout << "   python3 -c \"import pandas as pd; df=pd.read_csv('" << MetricsCsvPath (cfg) << "'); print(df)\"\n";
+  if (WantsBinary (cfg))
+    std::cout << "   python3 -c \"import glob,os,numpy as np,pandas as pd; d='" << BinaryResultsDir (cfg)
+              << "/packets'; print(pd.DataFrame({os.path.basename(f)[:-4]: np.load(f, mmap_mode='r') for f in glob.glob(d+'/*.npy')}))\"\n";
+}
+
+// ===== QoS comparison =====
+// Same scenario and RngRun with and without EDCA marking; gains are the
+// relative reduction of each latency statistic, positive when QoS helps.
+
+inline double LatencyGainPercent (double baselineMs, double qosMs)
+{
+  return (baselineMs > 0.0) ? (baselineMs - qosMs) / baselineMs * 100.0 : 0.0;
+}
+
+inline void ExportQosComparisonToCSV (const ScenarioResult& baseline, const ScenarioResult& qos,
+                                      const std::string& path)
+{
+  std::ofstream csvFile (path);
+  if (!csvFile.is_open ())
+    {
+      NS_LOG_ERROR ("Failed to open " << path << " for writing");
+      return;
+    }
+
+  csvFile << std::fixed << std::setprecision (6);
+  csvFile << "Device,BaselineRxPackets,QosRxPackets,BaselineLossPercent,QosLossPercent,"
+          << "BaselineAvgLatencyMs,QosAvgLatencyMs,AvgLatencyGainPercent,"
+          << "BaselineP99LatencyMs,QosP99LatencyMs,P99LatencyGainPercent,"
+          << "BaselineMaxLatencyMs,QosMaxLatencyMs,Direction\n";
+  for (uint32_t i = 0; i < baseline.devices.size () && i < qos.devices.size (); ++i)
+    {
+      const DeviceMetrics& b = baseline.devices[i];
+      const DeviceMetrics& q = qos.devices[i];
+      csvFile << b.name << "," << b.rxPackets << "," << q.rxPackets << ","
+              << b.lossRate << "," << q.lossRate << ","
+              << b.avgLatencyMs << "," << q.avgLatencyMs << ","
+              << LatencyGainPercent (b.avgLatencyMs, q.avgLatencyMs) << ","
+              << b.latency.GetQuantileMs (0.99) << "," << q.latency.GetQuantileMs (0.99) << ","
+              << LatencyGainPercent (b.latency.GetQuantileMs (0.99), q.latency.GetQuantileMs (0.99)) << ","
+              << b.latency.GetMax () / 1e6 << "," << q.latency.GetMax () / 1e6 << ","
+              << DirectionLabel (b.direction) << "\n";
+    }
+  std::cout << "\n📊 QoS comparison CSV exported: " << path << "\n";
+}
+
+inline void PrintQosComparison (const ScenarioResult& baseline, const ScenarioResult& qos)
+{
+  std::cout << "\n";
+  std::cout << "┌──────────────┬──────────┬──────────┬──────────┬──────────┬──────────┬──────────┐\n";
+  std::cout << "│ Device       │ Avg BE   │ Avg QoS  │ Gain     │ p99 BE   │ p99 QoS  │ Gain     │\n";
+  std::cout << "│              │ (ms)     │ (ms)     │ (%)      │ (ms)     │ (ms)     │ (%)      │\n";
+  std::cout << "├──────────────┼──────────┼──────────┼──────────┼──────────┼──────────┼──────────┤\n";
+  for (uint32_t i = 0; i < baseline.devices.size () && i < qos.devices.size (); ++i)
+    {
+      const DeviceMetrics& b = baseline.devices[i];
+      const DeviceMetrics& q = qos.devices[i];
+      double p99Base = b.latency.GetQuantileMs (0.99);
+      double p99Qos = q.latency.GetQuantileMs (0.99);
+      std::cout << "│ " << std::left << std::setw(12) << DisplayName (b)
+                << " │ " << std::right << std::setw(8) << std::fixed << std::setprecision(3) << b.avgLatencyMs
+                << " │ " << std::setw(8) << q.avgLatencyMs
+                << " │ " << std::setw(8) << std::setprecision(1) << LatencyGainPercent (b.avgLatencyMs, q.avgLatencyMs)
+                << " │ " << std::setw(8) << std::setprecision(3) << p99Base
+                << " │ " << std::setw(8) << p99Qos
+                << " │ " << std::setw(8) << std::setprecision(1) << LatencyGainPercent (p99Base, p99Qos)
+                << " │\n";
+    }
+  std::cout << "└──────────────┴──────────┴──────────┴──────────┴──────────┴──────────┴──────────┘\n";
+}
+
+// ===== Sweep summaries =====
+// One row per scenario, device and direction: mean and 95% CI half-width
+// over the replications, plus percentiles of all their packets pooled.
+
+inline void ExportSweepSummaryToCSV (const std::map<uint32_t, ScenarioSummary>& summaries,
+                                     bool adaptive, const std::string& path)
+{
+  std::ofstream csvFile (path);
+  if (!csvFile.is_open ())
+    {
+      NS_LOG_ERROR ("Failed to open " << path << " for writing");
+      return;
+    }
+  csvFile << std::fixed << std::setprecision (6);
+  csvFile << "Scenario,SimulationTimeSec,Rooms,Qos,ServerTier,ChannelPlan,Fidelity,"
+          << "NeighbourBss,BackgroundTraffic,BssColoring,ObssPdLevel,BatteryClasses,PowerSave,Replications,LostRuns,SafetyStops,"
+          << "Device,Direction,AvgLatencyMs,AvgLatencyCi95Ms,P99LatencyMs,P99LatencyCi95Ms,"
+          << "LossPercent,LossCi95Percent,SuccessRatePercent,SuccessRateCi95Percent,TaskCompletedPercent,"
+          << "PooledP50LatencyMs,PooledP99LatencyMs,PooledP999LatencyMs,PooledMaxLatencyMs,CiConverged,"
+          << "EnergyJ,EnergyCi95J,BatteryLifeHours,BatteryLifeCi95Hours\n";
+  for (const auto& entry : summaries)
+    {
+      const ScenarioSummary& s = entry.second;
+      const ScenarioConfig& c = s.config;
+      for (const auto& d : s.devices)
+        {
+          csvFile << entry.first << "," << c.simulationTime << "," << c.rooms << ","
+                  << (c.qos ? "Yes" : "No") << "," << c.serverTier << "," << c.channelPlan << ","
+                  << c.fidelity << "," << c.neighbourBss << "," << c.backgroundTraffic << ","
+                  << c.bssColoring << "," << c.obssPdLevel << "," << ClassListLabel (c.batteryClasses) << ","
+                  << c.powerSave << "," << s.replications << "," << s.lostRuns << "," << s.safetyStops << ","
+                  << d.device.name << "," << DirectionLabel (d.device.direction) << ","
+                  << d.avgLatencyMs.mean << "," << d.avgLatencyMs.Ci95 () << ","
+                  << d.p99LatencyMs.mean << "," << d.p99LatencyMs.Ci95 () << ","
+                  << d.lossPercent.mean << "," << d.lossPercent.Ci95 () << ","
+                  << d.successPercent.mean << "," << d.successPercent.Ci95 () << ","
+                  << 100.0 * d.completed / d.avgLatencyMs.n << ","
+                  << d.pooled.GetQuantileMs (0.50) << "," << d.pooled.GetQuantileMs (0.99) << ","
+                  << d.pooled.GetQuantileMs (0.999) << "," << d.pooled.GetMax () / 1e6 << ","
+                  << (adaptive ? (s.converged ? "Yes" : "No") : "-") << ","
+                  << d.energyJ.mean << "," << d.energyJ.Ci95 () << ","
+                  << d.batteryLifeHours.mean << "," << d.batteryLifeHours.Ci95 () << "\n";
+        }
+    }
+  std::cout << "📊 Sweep summary exported: " << path << "\n";
+}
+
+inline void PrintSweepSummary (const std::map<uint32_t, ScenarioSummary>& summaries, bool adaptive)
+{
+  for (const auto& entry : summaries)
+    {
+      const ScenarioSummary& s = entry.second;
+      std::cout << "\nScenario " << entry.first << ": " << s.replications << " replications";
+      if (adaptive)
+        std::cout << (s.converged ? " (CI targets met)" : " (⚠️  CI targets not met)");
+      if (s.lostRuns > 0)
+        std::cout << " (⚠️  " << s.lostRuns << " lost with their workers)";
+      std::cout << ", "
+                << s.safetyStops << " safety stops, "
+                << std::fixed << std::setprecision (2) << s.wallSeconds.mean << " s wall per run\n";
+      std::cout << "┌──────────────┬────────────────────┬────────────────────┬────────────────────┬──────────┐\n";
+      std::cout << "│ Device       │ Latency (ms)       │ p99 (ms)           │ Loss (%)           │ Done (%) │\n";
+      std::cout << "│              │ mean ± 95% CI      │ mean ± 95% CI      │ mean ± 95% CI      │          │\n";
+      std::cout << "├──────────────┼────────────────────┼────────────────────┼────────────────────┼──────────┤\n";
+      for (const auto& d : s.devices)
+        {
+          std::cout << "│ " << std::left << std::setw(12) << DisplayName (d.device) << std::right
+                    << " │ " << std::setw(8) << std::setprecision(3) << d.avgLatencyMs.mean
+                    << " ± " << std::setw(7) << d.avgLatencyMs.Ci95 ()
+                    << " │ " << std::setw(8) << d.p99LatencyMs.mean
+                    << " ± " << std::setw(7) << d.p99LatencyMs.Ci95 ()
+                    << " │ " << std::setw(8) << std::setprecision(2) << d.lossPercent.mean
+                    << " ± " << std::setw(7) << d.lossPercent.Ci95 ()
+                    << " │ " << std::setw(8) << std::setprecision(1) << 100.0 * d.completed / d.avgLatencyMs.n
+                    << " │\n";
+        }
+      std::cout << "└──────────────┴────────────────────┴────────────────────┴────────────────────┴──────────┘\n";
+    }
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_EXPORT_H */
@@ -0,0 +1,191 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Fixed-size latency histogram shared by the collector, exporters and sweeps
+ */
+
+#ifndef SURGICAL_HISTOGRAM_H
+#define SURGICAL_HISTOGRAM_H
+
+#include "surgical-common.h"
+
+namespace ns3 {
+
+// ===== Latency histogram =====
+// Log-linear (HDR-style) histogram of nanosecond delays: 32 sub-buckets per
+// power of two, so any recorded value is reported within ~3%. The 1216
+// counters cover 0 ns .. ~73 min and never grow with the number of samples;
+// histograms merge by adding counters.
+class LatencyHistogram
+{
+public:
+  static const uint32_t SUB_BUCKET_BITS = 5;
+  static const uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+  static const uint32_t MAX_SHIFT = 36;
+  static const uint32_t BUCKETS = (MAX_SHIFT + 2) * SUB_BUCKETS;
+
+  void Record (int64_t ns);
+  void Merge (const LatencyHistogram& other);
+
+  uint64_t GetCount () const;
+  int64_t GetMax () const;
+  // Value at quantile q in [0, 1], in nanoseconds (0 when empty)
+  int64_t GetQuantile (double q) const;
+  double GetQuantileMs (double q) const;
+  // Samples certainly above ns: only buckets lying entirely above it count
+  uint64_t GetCountAbove (int64_t ns) const;
+
+  // Sparse "index:count;..." form used by the sweep part files
+  std::string Serialize () const;
+  static LatencyHistogram Deserialize (const std::string& text);
+
+private:
+  static uint32_t BucketIndex (uint64_t ns);
+  static uint64_t BucketValue (uint32_t index);
+  static uint64_t BucketLow (uint32_t index);
+
+  std::array<uint32_t, BUCKETS> m_counts {};
+  uint64_t m_count = 0;
+  int64_t m_min = std::numeric_limits<int64_t>::max ();
+  int64_t m_max = 0;
+};
+
+inline uint32_t LatencyHistogram::BucketIndex (uint64_t ns)
+{
+  if (ns < 2 * SUB_BUCKETS)
+    {
+      return ns;
+    }
+  uint32_t shift = (63 - __builtin_clzll (ns)) - SUB_BUCKET_BITS;
+  if (shift > MAX_SHIFT)
+    {
+      return BUCKETS - 1;
+    }
+  return shift * SUB_BUCKETS + (ns >> shift);
+}
+
+// Midpoint of the bucket's value range
+inline uint64_t LatencyHistogram::BucketValue (uint32_t index)
+{
+  if (index < 2 * SUB_BUCKETS)
+    {
+      return index;
+    }
+  uint32_t shift = index / SUB_BUCKETS - 1;
+  uint64_t mantissa = index % SUB_BUCKETS + SUB_BUCKETS;
+  return (mantissa << shift) + ((1ull << shift) >> 1);
+}
+
+// Smallest value mapped to the bucket
+inline uint64_t LatencyHistogram::BucketLow (uint32_t index)
+{
+  if (index < 2 * SUB_BUCKETS)
+    {
+      return index;
+    }
+  uint32_t shift = index / SUB_BUCKETS - 1;
+  return static_cast<uint64_t> (index % SUB_BUCKETS + SUB_BUCKETS) << shift;
+}
+
+inline void LatencyHistogram::Record (int64_t ns)
+{
+  ns = std::max<int64_t> (ns, 0);
+  ++m_counts[BucketIndex (ns)];
+  ++m_count;
+  m_min = std::min (m_min, ns);
+  m_max = std::max (m_max, ns);
+}
+
+inline void LatencyHistogram::Merge (const LatencyHistogram& other)
+{
+  for (uint32_t i = 0; i < BUCKETS; ++i)
+    {
+      m_counts[i] += other.m_counts[i];
+    }
+  m_count += other.m_count;
+  m_min = std::min (m_min, other.m_min);
+  m_max = std::max (m_max, other.m_max);
+}
+
+inline uint64_t LatencyHistogram::GetCount () const
+{
+  return m_count;
+}
+
+inline int64_t LatencyHistogram::GetMax () const
+{
+  return m_max;
+}
+
+inline int64_t LatencyHistogram::GetQuantile (double q) const
+{
+  if (m_count == 0)
+    {
+      return 0;
+    }
+  uint64_t rank = std::max<uint64_t> (1, static_cast<uint64_t> (std::ceil (q * m_count)));
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < BUCKETS; ++i)
+    {
+      seen += m_counts[i];
+      if (seen >= rank)
+        {
+          // Never report outside the exact observed range
+          int64_t v = static_cast<int64_t> (BucketValue (i));
+          return std::min (std::max (v, m_min), m_max);
+        }
+    }
+  return m_max;
+}
+
+inline double LatencyHistogram::GetQuantileMs (double q) const
+{
+  return GetQuantile (q) / 1e6;
+}
+
+inline uint64_t LatencyHistogram::GetCountAbove (int64_t ns) const
+{
+  uint64_t above = 0;
+  for (uint32_t i = BUCKETS; i-- > 0 && static_cast<int64_t> (BucketLow (i)) > ns; )
+    {
+      above += m_counts[i];
+    }
+  return above;
+}
+
+inline std::string LatencyHistogram::Serialize () const
+{
+  std::ostringstream out;
+  out << m_min << ";" << m_max;
+  for (uint32_t i = 0; i < BUCKETS; ++i)
+    {
+      if (m_counts[i] > 0)
+        {
+          out << ";" << i << ":" << m_counts[i];
+        }
+    }
+  return out.str ();
+}
+
+inline LatencyHistogram LatencyHistogram::Deserialize (const std::string& text)
+{
+  LatencyHistogram h;
+  std::istringstream in (text);
+  std::string item;
+  if (std::getline (in, item, ';')) h.m_min = std::stoll (item);
+  if (std::getline (in, item, ';')) h.m_max = std::stoll (item);
+  while (std::getline (in, item, ';'))
+    {
+      size_t colon = item.find (':');
+      if (colon == std::string::npos) continue;
+      uint32_t index = std::stoul (item.substr (0, colon));
+      uint32_t count = std::stoul (item.substr (colon + 1));
+      if (index >= BUCKETS) continue;
+      h.m_counts[index] += count;
+      h.m_count += count;
+    }
+  return h;
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_HISTOGRAM_H */
@@ -0,0 +1,62 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Surgical IoMT benchmark suite
+ *
+ * Runs the Smart-OR scenario at 1, 4, 16, 64 and 256 stations and at 10 s,
+ * 60 s and 600 s simulated time (--stations / --durations select a subset)
+ * with fixed RngSeed/RngRun, one forked process per case, and records wall
+ * time, events/s and peak RSS in surgical_benchmark.csv.
+ *
+ * Regression check against a stored baseline:
+ *   ./ns3 run "surgical-iomt-bench --baseline=bench_base.csv --updateBaseline"
+ *   ./ns3 run "surgical-iomt-bench --baseline=bench_base.csv --tolerance=0.1"
+ * The second run exits with status 1 when any case's events/s drop more than
+ * 10% below the baseline. Baselines only compare on the same machine.
+ *
+ * Fidelity trade-off: --fidelities=fast,default,high runs every case at each
+ * Wi-Fi fidelity and reports its events/s next to its mean latency error
+ * relative to the high-fidelity run of the same case.
+ *
+ * Collector overhead: --collectorPackets=1000000 times the per-packet metric
+ * path (send and receive sinks) without a simulation and counts its heap
+ * allocations; it exits with status 1 if any path but the packet-tag
+ * reference allocates.
+ *
+ * Distributed speedup, against a sequential baseline of the same cases:
+ *   mpirun -np 4 ./surgical-iomt-bench --distributed --channelPlan=orthogonal \
+ *     --stations=64,256 --durations=60 --baseline=bench_base.csv
+ * Rooms are spread over the ranks and rank 0 prints wall-clock speedups.
+ */
+
+#include "surgical-benchmark.h"
+
+using namespace ns3;
+
+// Heap allocation counter for the collector microbenchmark; operator new can
+// be replaced once per program, so it lives in the program's only unit
+std::atomic<uint64_t> ns3::g_benchmarkAllocations (0);
+
+void* operator new (std::size_t size)
+{
+  g_benchmarkAllocations.fetch_add (1, std::memory_order_relaxed);
+  if (void* p = std::malloc (size ? size : 1))
+    {
+      return p;
+    }
+  throw std::bad_alloc ();
+}
+
+void operator delete (void* p) noexcept
+{
+  std::free (p);
+}
+
+void operator delete (void* p, std::size_t) noexcept
+{
+  std::free (p);
+}
+
+int main (int argc, char *argv[])
+{
+  return BenchmarkMain (argc, argv);
+}
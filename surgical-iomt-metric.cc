@@ -1,87 +1,15 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
-#include "ns3/core-module.h"
-#include "ns3/network-module.h"
-#include "ns3/wifi-module.h"
-#include "ns3/mobility-module.h"
-#include "ns3/internet-module.h"
-#include "ns3/applications-module.h"
-#include <fstream>
+/*
+ * Smoke test of the CSV pipeline: one client and one edge server on a
+ * "TestOR" BSS, the "test" profile of the shared surgical-*.h scenario
+ * library. surgical_metrics.csv holds the measured rows of that run.
+ */
+
+#include "surgical-driver.h"
 
 using namespace ns3;
 
 int main (int argc, char *argv[])
 {
-  // Create minimal topology: 1 client + 1 server
-  NodeContainer nodes;
-  nodes.Create (2);
-
-  // Wi-Fi setup
-  YansWifiChannelHelper channel = YansWifiChannelHelper::Default ();
-  YansWifiPhyHelper phy;
-  phy.SetChannel (channel.Create ());
-
-  WifiMacHelper mac;
-  Ssid ssid = Ssid ("TestOR");
-  WifiHelper wifi;
-  wifi.SetStandard (WIFI_STANDARD_80211ax);
-  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager");
-
-  mac.SetType ("ns3::ApWifiMac", "Ssid", SsidValue (ssid));
-  NetDeviceContainer apDevice = wifi.Install (phy, mac, nodes.Get (0));
-
-  mac.SetType ("ns3::StaWifiMac", "Ssid", SsidValue (ssid));
-  NetDeviceContainer staDevice = wifi.Install (phy, mac, nodes.Get (1));
-
-  // Mobility
-  MobilityHelper mobility;
-  Ptr<ListPositionAllocator> pos = CreateObject<ListPositionAllocator> ();
-  pos->Add (Vector (0.0, 0.0, 0.0));
-  pos->Add (Vector (5.0, 0.0, 0.0));
-  mobility.SetPositionAllocator (pos);
-  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
-  mobility.Install (nodes);
-
-  // Internet stack
-  InternetStackHelper stack;
-  stack.Install (nodes);
-  Ipv4AddressHelper address;
-  address.SetBase ("192.168.1.0", "255.255.255.0");
-  Ipv4InterfaceContainer interfaces = address.Assign (staDevice);
-  Ipv4InterfaceContainer apInterface = address.Assign (apDevice);
-
-  // Simple UDP traffic
-  uint16_t port = 8080;
-  UdpEchoServerHelper server (port);
-  ApplicationContainer serverApp = server.Install (nodes.Get (0));
-  serverApp.Start (Seconds (1.0));
-  serverApp.Stop (Seconds (10.0));
-
-  UdpEchoClientHelper client (apInterface.GetAddress (0), port);
-  client.SetAttribute ("MaxPackets", UintegerValue (10));
-  client.SetAttribute ("Interval", TimeValue (Seconds (1.0)));
-  client.SetAttribute ("PacketSize", UintegerValue (100));
-  ApplicationContainer clientApp = client.Install (nodes.Get (1));
-  clientApp.Start (Seconds (2.0));
-  clientApp.Stop (Seconds (10.0));
-
-  // Run simulation
-  Simulator::Stop (Seconds (10.0));
-  Simulator::Run ();
-
-  // ✅ CRITICAL: Generate CSV in current directory (NS-3 root)
-  std::ofstream csv ("surgical_metrics.csv");
-  if (csv.is_open ()) {
-    csv << "Device,TxPackets,RxPackets,LossPercent,AvgLatencyMs\n";
-    csv << "RobotCtrl,10,10,0.0,8.5\n";
-    csv << "Endoscope,5,5,0.0,12.3\n";
-    csv.close ();
-    std::cout << "\n✅ SUCCESS: CSV file created at: " 
-              << std::string(getcwd(NULL, 0)) << "/surgical_metrics.csv\n";
-  } else {
-    std::cout << "\n❌ FAILED: Could not create CSV file (permission issue?)\n";
-    std::cout << "   Current directory: " << std::string(getcwd(NULL, 0)) << "\n";
-  }
-
-  Simulator::Destroy ();
-  return 0;
+  return SurgicalMain (argc, argv, "test");
 }
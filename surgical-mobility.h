@@ -0,0 +1,322 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Moving people, carts and devices: obstacle shadowing, scripted
+ * trajectories and latency binned by device position
+ */
+
+#ifndef SURGICAL_MOBILITY_H
+#define SURGICAL_MOBILITY_H
+
+#include "surgical-collector.h"
+
+namespace ns3 {
+
+// ===== Obstacle shadowing =====
+// Staff and C-arms are not network nodes, only mobility models. A link loses
+// 'Loss' dB for every obstacle within 'Radius' of the straight line between
+// its ends. Obstacle positions are re-read at most once per UpdateInterval,
+// on the first loss computation after it expires, so moving obstacles cost
+// no events of their own beyond their mobility models' leg changes, and the
+// per-packet cost is one segment distance per obstacle.
+
+class ObstacleShadowingLossModel : public PropagationLossModel
+{
+public:
+  static TypeId GetTypeId ();
+  ObstacleShadowingLossModel ();
+
+  void AddObstacle (Ptr<MobilityModel> obstacle);
+
+private:
+  double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const override;
+  int64_t DoAssignStreams (int64_t stream) override;
+  void Refresh () const;
+
+  double m_loss;
+  double m_radius;
+  Time m_updateInterval;
+  std::vector<Ptr<MobilityModel>> m_obstacles;
+  mutable std::vector<Vector> m_positions;  // snapshot taken at m_lastRefresh
+  mutable Time m_lastRefresh;
+  mutable bool m_refreshed;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (ObstacleShadowingLossModel);
+
+inline TypeId ObstacleShadowingLossModel::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::ObstacleShadowingLossModel")
+    .SetParent<PropagationLossModel> ()
+    .AddConstructor<ObstacleShadowingLossModel> ()
+    .AddAttribute ("Loss", "Extra loss per obstacle on the line of sight (dB)",
+                   DoubleValue (10.0),
+                   MakeDoubleAccessor (&ObstacleShadowingLossModel::m_loss),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Radius", "Obstacle radius (m)",
+                   DoubleValue (0.3),
+                   MakeDoubleAccessor (&ObstacleShadowingLossModel::m_radius),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("UpdateInterval", "How stale obstacle positions may get",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&ObstacleShadowingLossModel::m_updateInterval),
+                   MakeTimeChecker ());
+  return tid;
+}
+
+inline ObstacleShadowingLossModel::ObstacleShadowingLossModel ()
+  : m_loss (10.0),
+    m_radius (0.3),
+    m_refreshed (false)
+{
+}
+
+inline void ObstacleShadowingLossModel::AddObstacle (Ptr<MobilityModel> obstacle)
+{
+  m_obstacles.push_back (obstacle);
+  m_refreshed = false;
+}
+
+inline void ObstacleShadowingLossModel::Refresh () const
+{
+  Time now = Simulator::Now ();
+  if (m_refreshed && now - m_lastRefresh < m_updateInterval)
+    {
+      return;
+    }
+  m_positions.resize (m_obstacles.size ());
+  for (uint32_t i = 0; i < m_obstacles.size (); ++i)
+    {
+      m_positions[i] = m_obstacles[i]->GetPosition ();
+    }
+  m_lastRefresh = now;
+  m_refreshed = true;
+}
+
+// Distances in the floor plane: obstacles stand between the antennas whatever
+// their height
+inline double ObstacleShadowingLossModel::DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a,
+                                                         Ptr<MobilityModel> b) const
+{
+  Refresh ();
+  Vector pa = a->GetPosition ();
+  Vector pb = b->GetPosition ();
+  double dx = pb.x - pa.x;
+  double dy = pb.y - pa.y;
+  double length2 = dx * dx + dy * dy;
+  double loss = 0.0;
+  for (const auto& p : m_positions)
+    {
+      double t = (length2 > 0) ? ((p.x - pa.x) * dx + (p.y - pa.y) * dy) / length2 : 0.0;
+      t = std::min (1.0, std::max (0.0, t));
+      double ex = pa.x + t * dx - p.x;
+      double ey = pa.y + t * dy - p.y;
+      if (ex * ex + ey * ey < m_radius * m_radius)
+        {
+          loss += m_loss;
+        }
+    }
+  return txPowerDbm - loss;
+}
+
+inline int64_t ObstacleShadowingLossModel::DoAssignStreams (int64_t stream)
+{
+  return 0;
+}
+
+// ===== Room walls =====
+// Operating rooms sit on a square grid of pitch Spacing; walls run along
+// x = OffsetX + k * Spacing and y = OffsetY + k * Spacing, between the rooms'
+// floor areas. A link loses Loss dB for every wall its straight line
+// crosses, so a neighbouring room is one wall away and a diagonal one two.
+
+class RoomWallLossModel : public PropagationLossModel
+{
+public:
+  static TypeId GetTypeId ();
+  RoomWallLossModel ();
+
+private:
+  double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const override;
+  int64_t DoAssignStreams (int64_t stream) override;
+  int64_t Cell (double coordinate, double offset) const;
+
+  double m_loss;
+  double m_spacing;
+  double m_offsetX;
+  double m_offsetY;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (RoomWallLossModel);
+
+inline TypeId RoomWallLossModel::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::RoomWallLossModel")
+    .SetParent<PropagationLossModel> ()
+    .AddConstructor<RoomWallLossModel> ()
+    .AddAttribute ("Loss", "Loss per wall crossed (dB)",
+                   DoubleValue (15.0),
+                   MakeDoubleAccessor (&RoomWallLossModel::m_loss),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Spacing", "Distance between neighbouring walls (m)",
+                   DoubleValue (20.0),
+                   MakeDoubleAccessor (&RoomWallLossModel::m_spacing),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("OffsetX", "x of the first wall parallel to the y axis (m)",
+                   DoubleValue (12.5),
+                   MakeDoubleAccessor (&RoomWallLossModel::m_offsetX),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("OffsetY", "y of the first wall parallel to the x axis (m)",
+                   DoubleValue (12.0),
+                   MakeDoubleAccessor (&RoomWallLossModel::m_offsetY),
+                   MakeDoubleChecker<double> ());
+  return tid;
+}
+
+inline RoomWallLossModel::RoomWallLossModel ()
+  : m_loss (15.0),
+    m_spacing (20.0),
+    m_offsetX (12.5),
+    m_offsetY (12.0)
+{
+}
+
+inline int64_t RoomWallLossModel::Cell (double coordinate, double offset) const
+{
+  return static_cast<int64_t> (std::floor ((coordinate - offset) / m_spacing));
+}
+
+inline double RoomWallLossModel::DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a,
+                                                Ptr<MobilityModel> b) const
+{
+  if (m_spacing <= 0)
+    {
+      return txPowerDbm;
+    }
+  Vector pa = a->GetPosition ();
+  Vector pb = b->GetPosition ();
+  int64_t walls = std::abs (Cell (pa.x, m_offsetX) - Cell (pb.x, m_offsetX))
+    + std::abs (Cell (pa.y, m_offsetY) - Cell (pb.y, m_offsetY));
+  return txPowerDbm - walls * m_loss;
+}
+
+inline int64_t RoomWallLossModel::DoAssignStreams (int64_t stream)
+{
+  return 0;
+}
+
+// ===== Scripted trajectories =====
+// CSV lines "device,time_s,x_m,y_m" with positions relative to the device's
+// room origin; '#' starts a comment. Each listed device moves in straight
+// lines between its waypoints (WaypointMobilityModel) and holds its last
+// position afterwards.
+
+inline std::map<std::string, std::vector<Waypoint>> LoadTrajectoryFile (const std::string& path)
+{
+  std::ifstream in (path);
+  if (!in.is_open ())
+    {
+      NS_FATAL_ERROR ("Cannot open trajectory file " << path);
+    }
+  std::map<std::string, std::vector<Waypoint>> trajectories;
+  std::string line;
+  uint32_t lineNo = 0;
+  while (std::getline (in, line))
+    {
+      ++lineNo;
+      line = line.substr (0, line.find ('#'));
+      if (line.find_first_not_of (" \t\r") == std::string::npos)
+        {
+          continue;
+        }
+      std::istringstream row (line);
+      std::string field;
+      std::vector<std::string> f;
+      while (std::getline (row, field, ','))
+        {
+          f.push_back (field);
+        }
+      try
+        {
+          if (f.size () != 4)
+            {
+              throw std::invalid_argument ("field count");
+            }
+          trajectories[f[0]].push_back (Waypoint (Seconds (std::stod (f[1])),
+                                                  Vector (std::stod (f[2]), std::stod (f[3]), 0.0)));
+        }
+      catch (const std::exception&)
+        {
+          NS_FATAL_ERROR (path << ":" << lineNo << ": expected device,time_s,x_m,y_m");
+        }
+    }
+  for (auto& t : trajectories)
+    {
+      std::stable_sort (t.second.begin (), t.second.end (),
+                        [] (const Waypoint& a, const Waypoint& b) { return a.time < b.time; });
+    }
+  return trajectories;
+}
+
+// ===== Latency by position =====
+// Received packets are binned by the position of their device (the station
+// for uplink and downlink alike) at arrival, in square cells of 'cell'
+// metres relative to the room origin. One histogram per occupied cell and
+// flow, created on first use.
+
+struct PositionLatency {
+  uint32_t flow;
+  int32_t cellX;
+  int32_t cellY;
+  LatencyHistogram latency;
+};
+
+class PositionLatencyMap
+{
+public:
+  // 'devices[i]' and 'origins[i]' belong to device i; flow f is device f % N
+  PositionLatencyMap (const std::vector<Ptr<MobilityModel>>& devices,
+                      const std::vector<Vector>& origins, double cell);
+
+  void Record (uint32_t flow, Time delay);
+  // Cells ordered by flow, then x, then y
+  std::vector<PositionLatency> GetCells () const;
+
+private:
+  std::vector<Ptr<MobilityModel>> m_devices;
+  std::vector<Vector> m_origins;
+  double m_cell;
+  std::map<std::tuple<uint32_t, int32_t, int32_t>, LatencyHistogram> m_cells;
+};
+
+inline PositionLatencyMap::PositionLatencyMap (const std::vector<Ptr<MobilityModel>>& devices,
+                                               const std::vector<Vector>& origins, double cell)
+  : m_devices (devices),
+    m_origins (origins),
+    m_cell (cell)
+{
+  NS_ABORT_MSG_IF (cell <= 0, "position cell size must be positive");
+}
+
+inline void PositionLatencyMap::Record (uint32_t flow, Time delay)
+{
+  uint32_t device = flow % m_devices.size ();
+  Vector p = m_devices[device]->GetPosition ();
+  int32_t cx = static_cast<int32_t> (std::floor ((p.x - m_origins[device].x) / m_cell));
+  int32_t cy = static_cast<int32_t> (std::floor ((p.y - m_origins[device].y) / m_cell));
+  m_cells[std::make_tuple (flow, cx, cy)].Record (delay.GetNanoSeconds ());
+}
+
+inline std::vector<PositionLatency> PositionLatencyMap::GetCells () const
+{
+  std::vector<PositionLatency> cells;
+  cells.reserve (m_cells.size ());
+  for (const auto& c : m_cells)
+    {
+      cells.push_back ({std::get<0> (c.first), std::get<1> (c.first), std::get<2> (c.first), c.second});
+    }
+  return cells;
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_MOBILITY_H */
@@ -0,0 +1,214 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Event-loop profiler: a DefaultSimulatorImpl that times a sample of the
+ * events it runs and charges them to the class that scheduled them
+ */
+
+#ifndef SURGICAL_PROFILER_H
+#define SURGICAL_PROFILER_H
+
+#include "surgical-common.h"
+
+namespace ns3 {
+
+// ===== Event-loop profiler =====
+// One in every SampleEvery scheduled events is wrapped so that its Invoke ()
+// is timed with the wall clock. The event's source is the class of the member
+// function it calls, read from the C++ type of the MakeEvent functor (e.g.
+// "WifiPhy", "UdpEchoClient", "LatencyCollector"); free functions and
+// lambdas are grouped as "function". Unsampled events run unwrapped, so the
+// overhead is one counter increment per event plus two clock reads per
+// sample.
+
+struct EventSourceCost {
+  std::string source;
+  uint64_t sampledEvents = 0;
+  double sampledWallSeconds = 0.0;
+};
+
+struct EventProfile {
+  bool enabled = false;
+  uint32_t sampleEvery = 0;
+  uint64_t sampledEvents = 0;
+  double sampledWallSeconds = 0.0;
+  std::vector<EventSourceCost> sources;  // most expensive first
+};
+
+// "ns3::MakeEvent<void (ns3::WifiPhy::*)(), ns3::WifiPhy*>(...)::EventMemberImpl0"
+// -> "WifiPhy"
+inline std::string EventSourceName (const std::type_info& type)
+{
+  int status = 0;
+  char* demangled = abi::__cxa_demangle (type.name (), nullptr, nullptr, &status);
+  std::string name = (status == 0 && demangled) ? demangled : type.name ();
+  std::free (demangled);
+
+  std::string::size_type member = name.find ("::*)");
+  if (member == std::string::npos)
+    {
+      return "function";
+    }
+  std::string::size_type open = name.rfind ('(', member);
+  std::string source = name.substr (open + 1, member - open - 1);
+  if (source.compare (0, 5, "ns3::") == 0)
+    {
+      source = source.substr (5);
+    }
+  return source;
+}
+
+class SurgicalProfilingSimulatorImpl : public DefaultSimulatorImpl
+{
+public:
+  static TypeId GetTypeId ();
+  SurgicalProfilingSimulatorImpl ();
+
+  EventId Schedule (const Time& delay, EventImpl* event) override;
+  void ScheduleWithContext (uint32_t context, const Time& delay, EventImpl* event) override;
+  EventId ScheduleNow (EventImpl* event) override;
+
+  EventProfile GetProfile () const;
+
+private:
+  // Runs the wrapped event and adds its wall time to the source's total
+  class SampledEvent : public EventImpl
+  {
+  public:
+    SampledEvent (EventImpl* event, SurgicalProfilingSimulatorImpl* impl, uint32_t source);
+
+  private:
+    void Notify () override;
+
+    Ptr<EventImpl> m_event;
+    SurgicalProfilingSimulatorImpl* m_impl;
+    uint32_t m_source;
+  };
+
+  // 'event' itself or, for every SampleEvery-th call, a SampledEvent owning it
+  EventImpl* Sample (EventImpl* event);
+
+  uint32_t m_sampleEvery;
+  uint64_t m_scheduled;
+  std::unordered_map<std::type_index, uint32_t> m_sourceIndex;
+  std::vector<EventSourceCost> m_sources;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (SurgicalProfilingSimulatorImpl);
+
+inline TypeId SurgicalProfilingSimulatorImpl::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::SurgicalProfilingSimulatorImpl")
+    .SetParent<DefaultSimulatorImpl> ()
+    .AddConstructor<SurgicalProfilingSimulatorImpl> ()
+    .AddAttribute ("SampleEvery", "Time one in this many scheduled events",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&SurgicalProfilingSimulatorImpl::m_sampleEvery),
+                   MakeUintegerChecker<uint32_t> (1));
+  return tid;
+}
+
+inline SurgicalProfilingSimulatorImpl::SurgicalProfilingSimulatorImpl ()
+  : m_sampleEvery (100),
+    m_scheduled (0)
+{
+}
+
+inline EventId SurgicalProfilingSimulatorImpl::Schedule (const Time& delay, EventImpl* event)
+{
+  return DefaultSimulatorImpl::Schedule (delay, Sample (event));
+}
+
+inline void SurgicalProfilingSimulatorImpl::ScheduleWithContext (uint32_t context, const Time& delay,
+                                                                 EventImpl* event)
+{
+  DefaultSimulatorImpl::ScheduleWithContext (context, delay, Sample (event));
+}
+
+inline EventId SurgicalProfilingSimulatorImpl::ScheduleNow (EventImpl* event)
+{
+  return DefaultSimulatorImpl::ScheduleNow (Sample (event));
+}
+
+inline EventImpl* SurgicalProfilingSimulatorImpl::Sample (EventImpl* event)
+{
+  if (++m_scheduled % m_sampleEvery != 0)
+    {
+      return event;
+    }
+  const std::type_info& type = typeid (*event);
+  auto it = m_sourceIndex.find (type);
+  if (it == m_sourceIndex.end ())
+    {
+      EventSourceCost cost;
+      cost.source = EventSourceName (type);
+      // Different functor types of one class share its entry
+      auto same = std::find_if (m_sources.begin (), m_sources.end (),
+                                [&cost] (const EventSourceCost& c) { return c.source == cost.source; });
+      uint32_t index = same - m_sources.begin ();
+      if (same == m_sources.end ())
+        {
+          m_sources.push_back (cost);
+        }
+      it = m_sourceIndex.emplace (type, index).first;
+    }
+  return new SampledEvent (event, this, it->second);
+}
+
+inline EventProfile SurgicalProfilingSimulatorImpl::GetProfile () const
+{
+  EventProfile profile;
+  profile.enabled = true;
+  profile.sampleEvery = m_sampleEvery;
+  profile.sources = m_sources;
+  for (const auto& s : m_sources)
+    {
+      profile.sampledEvents += s.sampledEvents;
+      profile.sampledWallSeconds += s.sampledWallSeconds;
+    }
+  std::sort (profile.sources.begin (), profile.sources.end (),
+             [] (const EventSourceCost& a, const EventSourceCost& b)
+             { return a.sampledWallSeconds > b.sampledWallSeconds; });
+  return profile;
+}
+
+// The scheduler hands over one reference to 'event'; the wrapper keeps it
+inline SurgicalProfilingSimulatorImpl::SampledEvent::SampledEvent (EventImpl* event,
+                                                                  SurgicalProfilingSimulatorImpl* impl,
+                                                                  uint32_t source)
+  : m_event (event, false),
+    m_impl (impl),
+    m_source (source)
+{
+}
+
+inline void SurgicalProfilingSimulatorImpl::SampledEvent::Notify ()
+{
+  auto start = std::chrono::steady_clock::now ();
+  m_event->Invoke ();
+  EventSourceCost& cost = m_impl->m_sources[m_source];
+  cost.sampledWallSeconds += std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  ++cost.sampledEvents;
+}
+
+// Select the simulator implementation of the next run; takes effect when the
+// simulator is (re)created, i.e. before the first Simulator call of a run
+inline void SelectSimulatorImpl (bool profiling, uint32_t sampleEvery)
+{
+  if (profiling)
+    {
+      Config::SetDefault ("ns3::SurgicalProfilingSimulatorImpl::SampleEvery", UintegerValue (sampleEvery));
+    }
+  GlobalValue::Bind ("SimulatorImplementationType",
+                     StringValue (profiling ? "ns3::SurgicalProfilingSimulatorImpl" : "ns3::DefaultSimulatorImpl"));
+}
+
+// Profile of the current run, or a disabled one when it was not profiled
+inline EventProfile CollectEventProfile ()
+{
+  Ptr<SurgicalProfilingSimulatorImpl> impl = DynamicCast<SurgicalProfilingSimulatorImpl> (Simulator::GetImplementation ());
+  return impl ? impl->GetProfile () : EventProfile ();
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_PROFILER_H */
@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Real-time runs: RealtimeSimulatorImpl selection and a probe that measures
+ * how far the simulator falls behind the wall clock
+ */
+
+#ifndef SURGICAL_REALTIME_H
+#define SURGICAL_REALTIME_H
+
+#include "surgical-histogram.h"
+
+namespace ns3 {
+
+// ===== Real-time execution =====
+// Under RealtimeSimulatorImpl an event runs no earlier than its simulated
+// time on the wall clock. With BestEffort synchronization an event that is
+// already late runs at once, so a model too large for one CPU drifts
+// behind and whatever real traffic crosses it (see the emulation bridge in
+// SurgicalScenario::InstallEmulation) is delayed by that drift on top of
+// the modelled Wi-Fi delay; HardLimit aborts the run once the drift passes
+// the limit instead.
+
+// Select RealtimeSimulatorImpl for the next run; 'checksums' turns on real
+// IP/UDP checksums, which host stacks on the far side of a tap insist on
+inline void SelectRealtimeSimulatorImpl (const std::string& sync, Time hardLimit, bool checksums)
+{
+  Config::SetDefault ("ns3::RealtimeSimulatorImpl::SynchronizationMode", StringValue (sync));
+  Config::SetDefault ("ns3::RealtimeSimulatorImpl::HardLimit", TimeValue (hardLimit));
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::RealtimeSimulatorImpl"));
+  if (checksums)
+    {
+      GlobalValue::Bind ("ChecksumEnabled", BooleanValue (true));
+    }
+}
+
+// Real-time lag of a run: how late each probe ran on the wall clock
+struct RealtimeLagReport {
+  bool enabled = false;
+  uint64_t probes = 0;
+  LatencyHistogram lag;    // ns behind the wall clock, per probe
+  double jitterMs = 0.0;   // mean change of the lag between probes
+  uint64_t late = 0;       // probes later than the budget
+  double budgetMs = 0.0;
+
+  // Whether the run kept up: p99 lag within the budget
+  bool KeptUp () const;
+  double LatePercent () const;
+};
+
+inline bool RealtimeLagReport::KeptUp () const
+{
+  return probes > 0 && lag.GetQuantileMs (0.99) <= budgetMs;
+}
+
+inline double RealtimeLagReport::LatePercent () const
+{
+  return (probes > 0) ? 100.0 * late / probes : 0.0;
+}
+
+// A probe event every 'interval' of simulated time compares the simulated
+// time elapsed since the first probe with the wall-clock time elapsed; the
+// difference is the lag real traffic sees. The first probe runs when
+// Simulator::Run () starts, which is where RealtimeSimulatorImpl aligns the
+// two clocks.
+class RealtimeLagMonitor
+{
+public:
+  RealtimeLagMonitor (Time interval, double budgetMs);
+
+  void Start ();
+  const RealtimeLagReport& GetReport () const;
+
+private:
+  void Probe ();
+
+  Time m_interval;
+  int64_t m_budgetNs;
+  bool m_started;
+  std::chrono::steady_clock::time_point m_wallBase;
+  Time m_simBase;
+  int64_t m_lastLagNs;
+  double m_jitterSumNs;
+  RealtimeLagReport m_report;
+};
+
+inline RealtimeLagMonitor::RealtimeLagMonitor (Time interval, double budgetMs)
+  : m_interval (interval),
+    m_budgetNs (static_cast<int64_t> (budgetMs * 1e6)),
+    m_started (false),
+    m_lastLagNs (0),
+    m_jitterSumNs (0.0)
+{
+  NS_ABORT_MSG_IF (!interval.IsStrictlyPositive (), "the real-time probe interval must be positive");
+  m_report.enabled = true;
+  m_report.budgetMs = budgetMs;
+}
+
+inline void RealtimeLagMonitor::Start ()
+{
+  Simulator::ScheduleNow (&RealtimeLagMonitor::Probe, this);
+}
+
+inline void RealtimeLagMonitor::Probe ()
+{
+  auto wall = std::chrono::steady_clock::now ();
+  if (!m_started)
+    {
+      m_started = true;
+      m_wallBase = wall;
+      m_simBase = Simulator::Now ();
+    }
+  int64_t wallNs = std::chrono::duration_cast<std::chrono::nanoseconds> (wall - m_wallBase).count ();
+  int64_t lagNs = std::max<int64_t> (0, wallNs - (Simulator::Now () - m_simBase).GetNanoSeconds ());
+  if (m_report.probes > 0)
+    {
+      m_jitterSumNs += std::abs (lagNs - m_lastLagNs);
+      m_report.jitterMs = m_jitterSumNs / m_report.probes / 1e6;
+    }
+  ++m_report.probes;
+  m_report.lag.Record (lagNs);
+  m_report.late += (lagNs > m_budgetNs) ? 1 : 0;
+  m_lastLagNs = lagNs;
+  Simulator::Schedule (m_interval, &RealtimeLagMonitor::Probe, this);
+}
+
+inline const RealtimeLagReport& RealtimeLagMonitor::GetReport () const
+{
+  return m_report;
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_REALTIME_H */
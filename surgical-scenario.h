@@ -0,0 +1,2028 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * SurgicalScenario: configuration, device plan and topology of one run
+ */
+
+#ifndef SURGICAL_SCENARIO_H
+#define SURGICAL_SCENARIO_H
+
+#include "surgical-collector.h"
+#include "surgical-telemetry.h"
+#include "surgical-watchdog.h"
+#include "surgical-traffic.h"
+#include "surgical-profiler.h"
+#include "surgical-mobility.h"
+#include "surgical-distributed.h"
+#include "surgical-realtime.h"
+
+namespace ns3 {
+
+// Device classes present in every operating room, in per-room creation order
+enum DeviceClass {
+  ROBOT_CTRL = 0,
+  ENDOSCOPE,
+  VITAL_MON,
+  DEVICE_CLASS_COUNT
+};
+
+// Uplink: device to edge server. Downlink: edge server to device, only with
+// the one-way surgical sources. Collector flow = direction * stations + device.
+enum FlowDirection {
+  UPLINK = 0,
+  DOWNLINK,
+  FLOW_DIRECTION_COUNT
+};
+
+inline const char* DirectionLabel (FlowDirection direction)
+{
+  return direction == UPLINK ? "Uplink" : "Downlink";
+}
+
+// ===== CRITICAL FIX: Define struct BEFORE using it in functions =====
+struct DeviceMetrics {
+  std::string name;
+  uint32_t txPackets;
+  uint32_t rxPackets;
+  double lossRate;
+  double avgLatencyMs;
+  double avgJitterMs;
+  double taskCompletionTime;
+  bool taskCompleted;
+  DeviceClass deviceClass;
+  uint32_t room;
+  LatencyHistogram latency;  // every delivered packet's one-way delay
+  FlowDirection direction;
+  // Battery stations only (see ScenarioConfig::batteryClasses): radio energy
+  // of the device over the run, both directions, and the hours a full
+  // battery lasts at that average power. Only the uplink row carries them,
+  // so summing rows counts each radio once; 0 on downlink rows and for
+  // mains-powered devices.
+  double energyJ = 0.0;
+  double batteryLifeHours = 0.0;
+};
+
+// Row label for terminal tables: downlink rows get a " DL" suffix
+inline std::string DisplayName (const DeviceMetrics& r)
+{
+  return r.direction == UPLINK ? r.name : r.name + " DL";
+}
+
+// Everything a single run depends on; defaults reproduce the fixed Smart-OR
+// layout. Fields that change results also go into DescribeScenario
+// (surgical-cache.h).
+struct ScenarioConfig {
+  double simulationTime = 15.0;
+  uint32_t rngRun = 1;
+  // NetAnim is off by default: batch runs should not pay for XML tracing.
+  // When on, tracing is limited to [netAnimStart, netAnimStop) (stop 0 =
+  // end of run), packet metadata is kept for netAnimMetadataFraction of each
+  // second, and tracing stops once the file reaches netAnimMaxMb.
+  bool enableNetAnim = false;
+  double netAnimStart = 0.0;
+  double netAnimStop = 0.0;
+  double netAnimMetadataFraction = 0.0;
+  double netAnimMaxMb = 100.0;
+
+  // Output: "csv", "binary" or "both"; a non-empty runId names the files
+  std::string outputFormat = "csv";
+  std::string runId;
+
+  // Directory of the content-addressed result cache (see surgical-cache.h);
+  // empty = always simulate. attributeOverrides are the command line's
+  // ns-3 attribute and global value settings (--ns3::...=...), sorted, so
+  // that they are part of the cache key.
+  std::string resultCache;
+  std::vector<std::string> attributeOverrides;
+
+  // Per-packet trace: a record for every packet sent and received, written
+  // to PacketTracePath from a fixed packetTraceArenaKb arena by a background
+  // thread (see surgical-trace.h)
+  bool packetTrace = false;
+  uint32_t packetTraceArenaKb = 1024;
+
+  // Per-device time series every windowInterval (zero disables the sampler)
+  Time windowInterval = Seconds (0);
+
+  // Live telemetry of the sampler's latest windows every telemetryInterval
+  // wall-clock seconds, as JSON datagrams to telemetryUdp (host:port) and/or
+  // Prometheus gauges on telemetryHttpPort (see surgical-telemetry.h); the
+  // wall clock is checked every telemetryPoll of simulated time. Needs
+  // windowInterval.
+  std::string telemetryUdp;
+  uint16_t telemetryHttpPort = 0;
+  double telemetryInterval = 5.0;  // tracer_logger.py's INTERVAL
+  Time telemetryPoll = MilliSeconds (10);
+
+  // Warm start skips the settling phase: ARP caches are filled statically,
+  // stations probe actively for their AP, servers run from t = 0 and all
+  // class start times move earlier together so the first one is at
+  // warmStartSettle (see WarmStartShift).
+  bool warmStart = false;
+  Time warmStartSettle = MilliSeconds (50);
+
+  // Run under ns-3's distributed simulator (set by --distributed, see
+  // surgical-distributed.h); needs channelPlan=orthogonal with several ranks
+  bool distributed = false;
+
+  // Event-loop profiling: time one in profileSampleEvery events and report
+  // the cost per event source (see surgical-profiler.h)
+  bool profiling = false;
+  uint32_t profileSampleEvery = 100;
+
+  // Real time (see surgical-realtime.h): run under RealtimeSimulatorImpl
+  // with realtimeSync BestEffort or HardLimit (abort once realtimeHardLimit
+  // behind), probing the lag every realtimeProbe; a run keeps up when its
+  // p99 lag is within realtimeLagBudgetMs.
+  bool realtime = false;
+  std::string realtimeSync = "BestEffort";
+  Time realtimeHardLimit = MilliSeconds (100);
+  Time realtimeProbe = MilliSeconds (1);
+  double realtimeLagBudgetMs = 1.0;
+
+  // Emulation bridge, real time only (see InstallEmulation): tapStations
+  // extra stations in room 1 are host tap devices <tapPrefix>sta<k>
+  // (TapBridge ConfigureLocal), so host programs send through the modelled
+  // Wi-Fi; with tapEdge room 1's AP gets a wired port bridged to the
+  // existing host tap <tapPrefix>edge (UseBridge), e.g. a port of the
+  // Mininet-WiFi OVS switch the Ryu controller manages, at tapEdgeAddress.
+  uint32_t tapStations = 0;
+  bool tapEdge = false;
+  std::string tapPrefix = "or";
+  std::string tapEdgeAddress = "10.0.0.250";  // Mininet's default 10.0.0.0/8
+  std::string tapEdgeMask = "255.0.0.0";
+
+  // Robotic control safety limits: p99 latency and task completion time.
+  // With safetyStop the watchdog checks them every safetyCheckInterval and
+  // ends the run as soon as it is conclusively unsafe.
+  double safetyLatencyMs = 50.0;
+  double safetyTaskSec = 5.0;
+  bool safetyStop = false;
+  Time safetyCheckInterval = MilliSeconds (100);
+
+  // Topology: 'rooms' operating rooms, each with one edge-server AP
+  uint32_t rooms = 1;
+  uint32_t robotsPerRoom = 1;
+  uint32_t endoscopesPerRoom = 1;
+  uint32_t vitalsPerRoom = 1;
+  double roomSpacing = 20.0;  // metres between neighbouring room origins
+
+  // Mobility: "static" (fixed layout), "waypoint" (devices of the
+  // mobileClasses list, e.g. "vital,video", walk random waypoints within
+  // their room at up to mobilitySpeed, pausing mobilityPause) or "scripted"
+  // (devices named in trajectoryFile follow it, see LoadTrajectoryFile).
+  // obstaclesPerRoom people/carts walk the same way and shadow every link
+  // they stand on by obstacleLossDb; their positions are re-read every
+  // mobilityUpdateInterval. Whenever anything moves, latency is also
+  // reported per positionCell-metre square of the device's position.
+  std::string mobility = "static";
+  std::string mobileClasses = "vital";
+  std::string trajectoryFile;
+  double mobilitySpeed = 1.0;
+  Time mobilityPause = Seconds (2);
+  uint32_t obstaclesPerRoom = 0;
+  double obstacleLossDb = 10.0;
+  double obstacleRadius = 0.3;
+  Time mobilityUpdateInterval = MilliSeconds (100);
+  double positionCell = 1.0;
+  std::string ssid = "Smart-OR";  // room k of several gets "<ssid>-k"
+
+  // Channel plan: "shared" puts every room's BSS on one channel, so rooms
+  // contend with each other; "orthogonal" gives room k the k-th
+  // non-overlapping 20 MHz 5 GHz channel (reused after 25 rooms), and rooms
+  // on different channels neither interfere nor pay for each other's
+  // receptions.
+  std::string channelPlan = "shared";
+
+  // Co-existence: neighbourBss foreign BSSs per room (adjacent ORs, staff
+  // and guest Wi-Fi) on the room's channel, their APs neighbourDistance
+  // metres from the room's AP, each loaded by backgroundStations stations
+  // sending to it. backgroundTraffic "onoff" offers backgroundRateMbps of
+  // UDP per station, like `iperf -b 20M` on the testbed (naso/read_me);
+  // "bulk" runs a saturating TCP BulkSend; "none" only adds the beacons.
+  // Background traffic is best effort and starts at backgroundStart.
+  // bssColoring "distinct" gives every BSS, the rooms' included, its own HE
+  // BSS colour; obssPdLevel (dBm, 0 = off) then lets a station ignore
+  // inter-BSS frames received below that level (802.11ax spatial reuse).
+  uint32_t neighbourBss = 0;
+  uint32_t backgroundStations = 1;
+  std::string backgroundTraffic = "onoff";
+  double backgroundRateMbps = 20.0;
+  uint32_t backgroundPacketSize = 1400;
+  Time backgroundStart = Seconds (1.0);
+  double neighbourDistance = 8.0;
+  std::string bssColoring = "none";
+  double obssPdLevel = 0.0;
+
+  // Where the servers run: "edge" on each room's AP (the original model),
+  // "fog" on a fog node wired to every AP, or "cloud" on a cloud node behind
+  // the fog node. Link defaults are those of naso/surgical_iomt_m.py.
+  std::string serverTier = "edge";
+  std::string fogLinkRate = "1Gbps";
+  Time fogLinkDelay = MilliSeconds (1);
+  std::string cloudLinkRate = "100Mbps";
+  Time cloudLinkDelay = MilliSeconds (30);
+  double cloudLinkLossPercent = 0.1;  // per direction
+
+  // 802.11ax always runs EDCA; without qos every flow is unmarked and shares
+  // AC_BE. With qos each class sends with its DSCP, so robot control uses
+  // AC_VO, video AC_VI and vitals AC_BE, like the three HTB queues on the
+  // testbed AP (naso/read_me).
+  bool qos = false;
+
+  // PHY and rate control: transmit power of every AP and station, and the
+  // ConstantRateWifiManager data mode (e.g. HeMcs7; empty = its default)
+  double txPowerDbm = 16.0206;
+  std::string dataMode;
+
+  // Fidelity of the Wi-Fi model, traded against speed:
+  //  fast     YANS PHY without preamble detection over a unit-disk channel:
+  //           frames reach every PHY within fastRange metres at full power
+  //           and none beyond, for screening hundreds of stations
+  //  default  YANS PHY and log-distance loss (the original model)
+  //  high     spectrum PHY, log-distance loss plus wallLossDb per room wall
+  //           crossed, MinstrelHt rate control
+  // rateControl (constant, minstrel or ideal) overrides the fidelity's rate
+  // manager; dataMode applies to constant only.
+  std::string fidelity = "default";
+  std::string rateControl;
+  double fastRange = 30.0;
+  double wallLossDb = 15.0;
+
+  // Battery-powered stations: every station of the batteryClasses list
+  // (class keys as in mobileClasses, e.g. "vital,video"; empty = none) runs
+  // its radio from a batteryEnergyJ source at batteryVoltage through
+  // WifiRadioEnergyModel, and reports the energy it used and the battery
+  // life that rate of use gives. powerSave applies to those stations only:
+  //  off  always awake
+  //  psm  802.11 power-save mode, signalled to the AP with the PM bit
+  //  twt  an individual Target Wake Time agreement, emulated: from its
+  //       class's start the PHY is awake for twtWakeDuration every
+  //       twtInterval and asleep otherwise, stations of a room staggered
+  //       by one wake duration. ns-3 has no TWT, so the AP does not hold
+  //       downlink frames for a dozing station; use it for uplink flows.
+  std::string batteryClasses;
+  double batteryEnergyJ = 13320.0;  // 1000 mAh at 3.7 V
+  double batteryVoltage = 3.7;
+  std::string powerSave = "off";
+  Time twtInterval = MilliSeconds (100);
+  Time twtWakeDuration = MilliSeconds (10);
+
+  // "echo": UdpEchoClient streams answered by UdpEchoServer (the original
+  // model). "surgical": one-way SurgicalPeriodicSource (robot, vitals) and
+  // SurgicalVideoSource (endoscope, *Interval is the frame interval and
+  // *PacketSize the largest fragment) into PacketSinks.
+  std::string trafficModel = "echo";
+
+  // Per-class traffic. A class with traffic off keeps its stations (they
+  // still associate) but runs no client and reports no metrics. With the
+  // surgical model, *Downlink adds the same stream from the edge server to
+  // each device of the class, reported as separate Downlink rows (e.g. robot
+  // commands from the console next to haptic feedback going up).
+  bool robotTraffic = true;
+  Time robotStart = Seconds (2.0);
+  bool robotDownlink = false;
+  uint32_t robotMaxPackets = 100;
+  Time robotInterval = MilliSeconds (10);
+  uint32_t robotPacketSize = 64;
+  uint16_t robotPort = 8000;
+
+  bool videoTraffic = true;
+  Time videoStart = Seconds (2.5);
+  bool videoDownlink = false;
+  uint32_t videoMaxPackets = 500;
+  Time videoInterval = MicroSeconds (66667);
+  uint32_t videoPacketSize = 1400;
+  uint16_t videoPort = 8001;
+  double videoBitrateMbps = 8.0;  // surgical video source only
+  uint32_t videoGopLength = 30;
+  double videoIFrameRatio = 6.0;
+
+  bool vitalTraffic = true;
+  Time vitalStart = Seconds (3.0);
+  bool vitalDownlink = false;
+  uint32_t vitalMaxPackets = 15;
+  Time vitalInterval = Seconds (1.0);
+  uint32_t vitalPacketSize = 100;
+  uint16_t vitalPort = 8002;
+};
+
+// Latency of one device and direction while it was in one position cell
+struct PositionMetrics {
+  std::string name;
+  FlowDirection direction;
+  double cellX, cellY;  // lower-left corner of the cell, relative to the room origin (m)
+  LatencyHistogram latency;
+};
+
+// Per-run output: device metrics plus the cost of simulating them
+struct ScenarioResult {
+  std::vector<DeviceMetrics> devices;
+  std::vector<PositionMetrics> positions;  // only when something moves
+  uint32_t stations = 0;
+  uint64_t events = 0;
+  double wallSeconds = 0.0;
+  double peakRssMb = 0.0;
+  double simulatedSeconds = 0.0;  // less than simulationTime after a safety stop
+  SafetyViolation safety;
+  EventProfile profile;  // enabled only with cfg.profiling
+  uint32_t systemId = 0;  // MPI rank; only rank 0 holds merged results
+  uint32_t associations = 0;  // station associations seen, re-associations included
+  double backgroundMbps = 0.0;  // delivered by all neighbour BSSs; this rank's only when distributed
+  double lastAssociationSeconds = 0.0;
+  uint64_t traceRecords = 0;  // with packetTrace: records written and simulator waits for the writer
+  uint64_t traceStalls = 0;
+  RealtimeLagReport realtime;  // enabled only with cfg.realtime
+  bool cached = false;  // read from the result cache, not simulated
+};
+
+// surgical_metrics.csv, or surgical_metrics_<runId>.csv so parallel runs don't clobber it
+inline std::string MetricsCsvPath (const ScenarioConfig& cfg)
+{
+  return cfg.runId.empty () ? "surgical_metrics.csv" : "surgical_metrics_" + cfg.runId + ".csv";
+}
+
+// surgical_qos_compare.csv, or surgical_qos_compare_<runId>.csv
+inline std::string QosCompareCsvPath (const ScenarioConfig& cfg)
+{
+  return cfg.runId.empty () ? "surgical_qos_compare.csv" : "surgical_qos_compare_" + cfg.runId + ".csv";
+}
+
+// surgical_windows.csv, or one file per run when a runId is set
+inline std::string WindowsCsvPath (const ScenarioConfig& cfg)
+{
+  return cfg.runId.empty () ? "surgical_windows.csv"
+                            : "surgical_windows_" + cfg.runId + "_run" + std::to_string (cfg.rngRun) + ".csv";
+}
+
+// surgical_profile.json, or one file per run when a runId is set
+inline std::string ProfileJsonPath (const ScenarioConfig& cfg)
+{
+  return cfg.runId.empty () ? "surgical_profile.json"
+                            : "surgical_profile_" + cfg.runId + "_run" + std::to_string (cfg.rngRun) + ".json";
+}
+
+// surgical_positions.csv, or one file per run when a runId is set
+inline std::string PositionsCsvPath (const ScenarioConfig& cfg)
+{
+  return cfg.runId.empty () ? "surgical_positions.csv"
+                            : "surgical_positions_" + cfg.runId + "_run" + std::to_string (cfg.rngRun) + ".csv";
+}
+
+// surgical_trace.bin, or one file per run when a runId is set; each MPI rank
+// traces its own nodes into its own _rank<k> file
+inline std::string PacketTracePath (const ScenarioConfig& cfg, uint32_t rank = 0)
+{
+  std::string path = cfg.runId.empty () ? "surgical_trace"
+                                        : "surgical_trace_" + cfg.runId + "_run" + std::to_string (cfg.rngRun);
+  if (cfg.distributed)
+    {
+      path += "_rank" + std::to_string (rank);
+    }
+  return path + ".bin";
+}
+
+inline bool HasMobility (const ScenarioConfig& cfg)
+{
+  return cfg.mobility != "static" || cfg.obstaclesPerRoom > 0;
+}
+
+inline bool WantsCsv (const ScenarioConfig& cfg)
+{
+  return cfg.outputFormat == "csv" || cfg.outputFormat == "both";
+}
+
+inline bool WantsBinary (const ScenarioConfig& cfg)
+{
+  return cfg.outputFormat == "binary" || cfg.outputFormat == "both";
+}
+
+// surgical_results_<runId>, or surgical_results_run<RngRun> without a runId
+inline std::string BinaryResultsDir (const ScenarioConfig& cfg)
+{
+  return "surgical_results_" + (cfg.runId.empty () ? "run" + std::to_string (cfg.rngRun) : cfg.runId);
+}
+
+// Static description of a device class: legacy single-OR name, short name
+// used in generated names, NetAnim colour and QoS marking
+struct DeviceClassInfo {
+  const char* label;
+  const char* shortName;
+  uint8_t red, green, blue;
+  uint8_t tos;  // IP TOS byte with --qos; its top three bits are the 802.11 user priority
+  double anchorX, anchorY;  // first device's position relative to the room origin
+};
+
+static const DeviceClassInfo g_deviceClasses[DEVICE_CLASS_COUNT] = {
+  {"Robot Ctrl", "Robot", 255, 0, 0, 0xc0, 0.0, 0.0},  // CS6  -> UP 6, AC_VO
+  {"Endoscope ", "Endo", 0, 0, 255, 0x88, 5.0, 0.0},    // AF41 -> UP 4, AC_VI
+  {"Vital Mon", "Vital", 0, 255, 0, 0x00, 2.5, 4.0}     // BE   -> UP 0, AC_BE
+};
+
+// Edge server / AP position relative to the room origin
+static const double g_serverX = 2.5;
+static const double g_serverY = 2.0;
+
+// Floor area spanned by the class anchors; random waypoints stay inside it
+static const double g_roomSizeX = 5.0;
+static const double g_roomSizeY = 4.0;
+
+// Non-overlapping 20 MHz channels of the 5 GHz band, for channelPlan=orthogonal
+static const uint16_t g_orthogonalChannels[] = {
+  36, 40, 44, 48, 52, 56, 60, 64, 100, 104, 108, 112, 116,
+  120, 124, 128, 132, 136, 140, 144, 149, 153, 157, 161, 165
+};
+static const uint32_t g_nOrthogonalChannels = sizeof (g_orthogonalChannels) / sizeof (g_orthogonalChannels[0]);
+
+// iperf's port, for the background load of neighbour BSSs
+static const uint16_t g_backgroundPort = 5001;
+
+// Channel objects InstallWifi creates; rooms k and k + n share object k
+inline uint32_t ChannelObjectCount (const ScenarioConfig& cfg)
+{
+  return (cfg.channelPlan == "orthogonal") ? std::min (cfg.rooms, g_nOrthogonalChannels) : 1;
+}
+
+// Rate manager in use: rateControl, else minstrel at high fidelity and
+// constant otherwise
+inline std::string RateControl (const ScenarioConfig& cfg)
+{
+  if (!cfg.rateControl.empty ())
+    {
+      return cfg.rateControl;
+    }
+  return (cfg.fidelity == "high") ? "minstrel" : "constant";
+}
+
+// Class prefix of the ScenarioConfig fields, also used in mobileClasses
+inline const char* ClassKey (DeviceClass cls)
+{
+  static const char* keys[DEVICE_CLASS_COUNT] = {"robot", "video", "vital"};
+  return keys[cls];
+}
+
+struct TrafficProfile {
+  bool enabled;
+  bool downlink;
+  Time start;
+  uint32_t maxPackets;
+  Time interval;
+  uint32_t packetSize;
+  uint16_t port;  // server port uplink, device port downlink
+};
+
+// How much earlier every class starts with warm start: the earliest enabled
+// start is pulled in to warmStartSettle, the others keep their offsets
+inline Time WarmStartShift (const ScenarioConfig& cfg)
+{
+  if (!cfg.warmStart)
+    {
+      return Seconds (0);
+    }
+  Time earliest = Seconds (cfg.simulationTime);
+  if (cfg.robotTraffic) earliest = std::min (earliest, cfg.robotStart);
+  if (cfg.videoTraffic) earliest = std::min (earliest, cfg.videoStart);
+  if (cfg.vitalTraffic) earliest = std::min (earliest, cfg.vitalStart);
+  return std::max (Seconds (0), earliest - cfg.warmStartSettle);
+}
+
+// Echo servers and sinks: at 1 s like the original, or at once with warm start
+inline Time ServerStart (const ScenarioConfig& cfg)
+{
+  return cfg.warmStart ? Seconds (0) : Seconds (1.0);
+}
+
+// Background load keeps its offset from the surgical traffic under warm start
+inline Time BackgroundStart (const ScenarioConfig& cfg)
+{
+  return std::max (ServerStart (cfg), cfg.backgroundStart - WarmStartShift (cfg));
+}
+
+inline TrafficProfile GetTrafficProfile (const ScenarioConfig& cfg, DeviceClass cls)
+{
+  Time shift = WarmStartShift (cfg);
+  switch (cls)
+    {
+    case ROBOT_CTRL:
+      return {cfg.robotTraffic, cfg.robotDownlink, cfg.robotStart - shift, cfg.robotMaxPackets, cfg.robotInterval, cfg.robotPacketSize, cfg.robotPort};
+    case ENDOSCOPE:
+      return {cfg.videoTraffic, cfg.videoDownlink, cfg.videoStart - shift, cfg.videoMaxPackets, cfg.videoInterval, cfg.videoPacketSize, cfg.videoPort};
+    default:
+      return {cfg.vitalTraffic, cfg.vitalDownlink, cfg.vitalStart - shift, cfg.vitalMaxPackets, cfg.vitalInterval, cfg.vitalPacketSize, cfg.vitalPort};
+    }
+}
+
+inline uint32_t DevicesPerRoom (const ScenarioConfig& cfg, DeviceClass cls)
+{
+  switch (cls)
+    {
+    case ROBOT_CTRL:
+      return cfg.robotsPerRoom;
+    case ENDOSCOPE:
+      return cfg.endoscopesPerRoom;
+    default:
+      return cfg.vitalsPerRoom;
+    }
+}
+
+inline uint32_t StationsPerRoom (const ScenarioConfig& cfg)
+{
+  return cfg.robotsPerRoom + cfg.endoscopesPerRoom + cfg.vitalsPerRoom;
+}
+
+struct DeviceSpec {
+  std::string name;
+  DeviceClass deviceClass;
+  uint32_t room;
+  uint32_t index;  // within its class and room
+};
+
+// Room-major list of all stations. A single room with one device per class
+// keeps the legacy names so existing CSV consumers see the same rows.
+inline std::vector<DeviceSpec> BuildDevicePlan (const ScenarioConfig& cfg)
+{
+  bool legacy = (cfg.rooms == 1 && cfg.robotsPerRoom == 1
+                 && cfg.endoscopesPerRoom == 1 && cfg.vitalsPerRoom == 1);
+  std::vector<DeviceSpec> plan;
+  plan.reserve (cfg.rooms * StationsPerRoom (cfg));
+  for (uint32_t room = 0; room < cfg.rooms; ++room)
+    {
+      for (uint32_t c = 0; c < DEVICE_CLASS_COUNT; ++c)
+        {
+          DeviceClass cls = static_cast<DeviceClass> (c);
+          for (uint32_t i = 0; i < DevicesPerRoom (cfg, cls); ++i)
+            {
+              std::string name = legacy
+                ? g_deviceClasses[c].label
+                : "OR" + std::to_string (room + 1) + "/" + g_deviceClasses[c].shortName
+                    + std::to_string (i + 1);
+              plan.push_back ({name, cls, room, i});
+            }
+        }
+    }
+  return plan;
+}
+
+// A device's task is complete once every packet its client sends has arrived
+inline std::map<std::string, uint32_t> BuildTaskTargets (const ScenarioConfig& cfg)
+{
+  std::map<std::string, uint32_t> taskTargets;
+  for (const auto& d : BuildDevicePlan (cfg))
+    {
+      taskTargets[d.name] = GetTrafficProfile (cfg, d.deviceClass).maxPackets;
+    }
+  return taskTargets;
+}
+
+// Rooms are laid out on a square grid, roomSpacing apart
+inline Vector RoomOrigin (const ScenarioConfig& cfg, uint32_t room)
+{
+  uint32_t perRow = static_cast<uint32_t> (std::ceil (std::sqrt (cfg.rooms)));
+  return Vector ((room % perRow) * cfg.roomSpacing, (room / perRow) * cfg.roomSpacing, 0.0);
+}
+
+// The first device of a class sits at the class anchor; further ones fill a
+// 0.5 m grid growing from the anchor towards the edge server.
+inline Vector DevicePosition (const ScenarioConfig& cfg, const DeviceSpec& d)
+{
+  const DeviceClassInfo& info = g_deviceClasses[d.deviceClass];
+  Vector origin = RoomOrigin (cfg, d.room);
+  double sx = (info.anchorX > g_serverX) ? -1.0 : 1.0;
+  double sy = (info.anchorY > g_serverY) ? -1.0 : 1.0;
+  const uint32_t columns = 8;
+  return Vector (origin.x + info.anchorX + sx * 0.5 * (d.index % columns),
+                 origin.y + info.anchorY + sy * 0.5 * (d.index / columns),
+                 0.0);
+}
+
+// Class lists (mobileClasses, batteryClasses) hold class keys separated by
+// ',' or '+' ('+' inside sweep files, where a comma separates grid values),
+// or "all"
+inline bool ClassListContains (std::string list, DeviceClass cls)
+{
+  std::replace (list.begin (), list.end (), '+', ',');
+  std::istringstream keys (list);
+  std::string key;
+  while (std::getline (keys, key, ','))
+    {
+      if (key == "all" || key == ClassKey (cls))
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+inline bool IsMobileClass (const ScenarioConfig& cfg, DeviceClass cls)
+{
+  return ClassListContains (cfg.mobileClasses, cls);
+}
+
+inline bool IsBatteryClass (const ScenarioConfig& cfg, DeviceClass cls)
+{
+  return ClassListContains (cfg.batteryClasses, cls);
+}
+
+// A class list as one CSV field: '+' separators, "none" when empty
+inline std::string ClassListLabel (std::string list)
+{
+  std::replace (list.begin (), list.end (), ',', '+');
+  return list.empty () ? "none" : list;
+}
+
+// Random waypoint walk over the floor of 'room' at mobilitySpeed/2 ..
+// mobilitySpeed, pausing mobilityPause at every waypoint. The model only
+// schedules an event per leg; positions in between are computed on demand.
+inline Ptr<MobilityModel> CreateRoomWalker (const ScenarioConfig& cfg, uint32_t room, const Vector& start)
+{
+  Vector origin = RoomOrigin (cfg, room);
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  x->SetAttribute ("Min", DoubleValue (origin.x));
+  x->SetAttribute ("Max", DoubleValue (origin.x + g_roomSizeX));
+  Ptr<UniformRandomVariable> y = CreateObject<UniformRandomVariable> ();
+  y->SetAttribute ("Min", DoubleValue (origin.y));
+  y->SetAttribute ("Max", DoubleValue (origin.y + g_roomSizeY));
+  Ptr<RandomRectanglePositionAllocator> waypoints = CreateObject<RandomRectanglePositionAllocator> ();
+  waypoints->SetX (x);
+  waypoints->SetY (y);
+
+  Ptr<UniformRandomVariable> speed = CreateObject<UniformRandomVariable> ();
+  speed->SetAttribute ("Min", DoubleValue (cfg.mobilitySpeed / 2));
+  speed->SetAttribute ("Max", DoubleValue (cfg.mobilitySpeed));
+  Ptr<ConstantRandomVariable> pause = CreateObject<ConstantRandomVariable> ();
+  pause->SetAttribute ("Constant", DoubleValue (cfg.mobilityPause.GetSeconds ()));
+
+  Ptr<RandomWaypointMobilityModel> walker = CreateObject<RandomWaypointMobilityModel> ();
+  walker->SetAttribute ("Speed", PointerValue (speed));
+  walker->SetAttribute ("Pause", PointerValue (pause));
+  walker->SetAttribute ("PositionAllocator", PointerValue (waypoints));
+  walker->SetPosition (start);
+  return walker;
+}
+
+inline double PeakRssMb ()
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0;  // ru_maxrss is in KiB on Linux
+}
+
+// ===== Emulated Target Wake Time =====
+// One service period of a station's TWT agreement: wake the PHY, doze again
+// after 'wake' (postponed by the PHY while it is transmitting or receiving)
+// and come back 'interval' later. Frames queued while dozing wait in the MAC.
+inline void TwtServicePeriod (Ptr<WifiPhy> phy, Time wake, Time interval)
+{
+  phy->ResumeFromSleep ();
+  Simulator::Schedule (wake, [phy] () { phy->SetSleepMode (); });
+  Simulator::Schedule (interval, &TwtServicePeriod, phy, wake, interval);
+}
+
+// ===== Bounded NetAnim tracing =====
+
+static const char* g_netAnimFile = "surgical-iomt-metrics.xml";
+
+// Freeze the trace (by closing its time window) once the XML passes maxBytes
+inline void CheckNetAnimSize (AnimationInterface* anim, uint64_t maxBytes, Time interval)
+{
+  struct stat st;
+  if (stat (g_netAnimFile, &st) == 0 && static_cast<uint64_t> (st.st_size) >= maxBytes)
+    {
+      NS_LOG_WARN ("NetAnim trace reached " << st.st_size << " bytes at " << Simulator::Now ().GetSeconds ()
+                   << " s; no further animation is recorded");
+      anim->SetStopTime (Simulator::Now ());
+      return;
+    }
+  Simulator::Schedule (interval, &CheckNetAnimSize, anim, maxBytes, interval);
+}
+
+// Duty-cycle packet metadata: on for 'on', off for 'off', repeating
+inline void SampleNetAnimMetadata (AnimationInterface* anim, bool enable, Time on, Time off)
+{
+  anim->EnablePacketMetadata (enable);
+  Simulator::Schedule (enable ? on : off, &SampleNetAnimMetadata, anim, !enable, on, off);
+}
+
+// Returns null when NetAnim is disabled; the interface must outlive Simulator::Run ()
+inline std::unique_ptr<AnimationInterface> SetupNetAnim (const ScenarioConfig& cfg)
+{
+  if (!cfg.enableNetAnim)
+    {
+      return nullptr;
+    }
+
+  std::unique_ptr<AnimationInterface> anim (new AnimationInterface (g_netAnimFile));
+  double stop = (cfg.netAnimStop > 0.0) ? std::min (cfg.netAnimStop, cfg.simulationTime) : cfg.simulationTime;
+  anim->SetStartTime (Seconds (cfg.netAnimStart));
+  anim->SetStopTime (Seconds (stop));
+  // One file only (the size cap below bounds it); fixed positions need no
+  // polling, moving ones are sampled at the mobility update granularity
+  anim->SetMaxPktsPerTraceFile (std::numeric_limits<uint64_t>::max ());
+  anim->SetMobilityPollInterval (HasMobility (cfg) ? cfg.mobilityUpdateInterval : Seconds (cfg.simulationTime));
+
+  if (cfg.netAnimMetadataFraction >= 1.0)
+    {
+      anim->EnablePacketMetadata (true);
+    }
+  else if (cfg.netAnimMetadataFraction > 0.0)
+    {
+      // Enable once before any packet exists so packet printing is set up,
+      // then alternate from the start of the trace window
+      anim->EnablePacketMetadata (true);
+      anim->EnablePacketMetadata (false);
+      Time on = Seconds (cfg.netAnimMetadataFraction);
+      Time off = Seconds (1.0 - cfg.netAnimMetadataFraction);
+      Simulator::Schedule (Seconds (cfg.netAnimStart), &SampleNetAnimMetadata, anim.get (), true, on, off);
+    }
+
+  Simulator::Schedule (Seconds (cfg.netAnimStart), &CheckNetAnimSize, anim.get (),
+                       static_cast<uint64_t> (cfg.netAnimMaxMb * 1024 * 1024), MilliSeconds (500));
+  return anim;
+}
+
+// ===== Scenario builder =====
+// One run of the Smart-OR model. Build () creates the topology and traffic
+// in numbered stages; Run () simulates it, extracts per-device metrics and
+// destroys the Simulator so the next scenario starts from a clean state.
+
+class SurgicalScenario
+{
+public:
+  // With 'binary' set, every received packet is also appended to its packets table
+  explicit SurgicalScenario (const ScenarioConfig& cfg, BinaryResults* binary = nullptr);
+
+  const ScenarioConfig& GetConfig () const;
+  const std::vector<DeviceSpec>& GetPlan () const;
+
+  void Build ();
+  // Builds first if Build () was not called
+  ScenarioResult Run ();
+
+private:
+  void CreateNodes ();
+  void InstallWifi ();
+  void InstallBackbone ();
+  void InstallEnergy ();
+  void InstallMobility ();
+  void InstallNetAnim ();
+  void InstallInternet ();
+  void InstallApplications ();
+  void InstallSurgicalSource (uint32_t device, FlowDirection direction, const TrafficProfile& profile);
+  uint32_t FlowIndex (uint32_t device, FlowDirection direction) const;
+  void InstallBackground ();
+  void InstallEmulation ();
+  void InstallWatchdog ();
+  void NoteAssociation (Mac48Address);
+  // Node running the servers for 'room', and all such nodes this rank runs
+  Ptr<Node> ServerNode (uint32_t room) const;
+  NodeContainer ServerHosts () const;
+  // Whether this rank runs the node's applications (always when sequential)
+  bool IsLocal (Ptr<Node> node) const;
+  void ExtractMetrics (ScenarioResult& result) const;
+
+  ScenarioConfig m_cfg;
+  BinaryResults* m_binary;
+  std::vector<DeviceSpec> m_plan;
+  bool m_built;
+  uint32_t m_rank;  // MPI rank, 0 when sequential
+
+  NodeContainer m_stations;
+  NodeContainer m_servers;  // one AP per room, also the edge server
+  Ptr<Node> m_fog;          // fog and cloud tiers, null with serverTier=edge
+  Ptr<Node> m_cloud;
+  std::vector<NetDeviceContainer> m_fogLinks;  // by room: AP, fog
+  NetDeviceContainer m_cloudLink;              // fog, cloud
+  std::vector<NetDeviceContainer> m_apDevices;
+  std::vector<NetDeviceContainer> m_staDevices;
+  NodeContainer m_neighbourAps;       // room-major, neighbourBss per room
+  NodeContainer m_backgroundStations; // by neighbour BSS, backgroundStations each
+  std::vector<NetDeviceContainer> m_neighbourApDevices;  // by neighbour BSS
+  std::vector<NetDeviceContainer> m_backgroundDevices;
+  std::vector<Ipv4Address> m_neighbourApAddress;
+  std::vector<Ptr<PacketSink>> m_backgroundSinks;
+  NodeContainer m_tapStations;    // emulated stations of room 1
+  NetDeviceContainer m_tapDevices;
+  Ptr<Node> m_tapEdge;            // far end of the AP's wired port, null without tapEdge
+  NetDeviceContainer m_tapEdgeLink;
+  std::vector<Ipv4Address> m_serverAddress;
+  std::vector<Ipv4Address> m_stationAddress;  // by device plan index
+  std::vector<Ptr<energy::DeviceEnergyModel>> m_energy;  // by device plan index, null off battery
+  Ptr<ObstacleShadowingLossModel> m_obstacleLoss;  // null without obstacles
+  std::vector<Ptr<MobilityModel>> m_obstacles;
+  uint32_t m_associations;
+  Time m_lastAssociation;
+
+  std::unique_ptr<AnimationInterface> m_anim;
+  std::unique_ptr<PacketTraceWriter> m_trace;
+  std::unique_ptr<LatencyCollector> m_collector;  // see FlowIndex ()
+  std::unique_ptr<WindowedSampler> m_sampler;
+  std::unique_ptr<TelemetryExporter> m_telemetry;
+  std::unique_ptr<RealtimeLagMonitor> m_lag;
+  std::unique_ptr<SafetyWatchdog> m_watchdog;
+  std::unique_ptr<PositionLatencyMap> m_positionMap;
+};
+
+inline SurgicalScenario::SurgicalScenario (const ScenarioConfig& cfg, BinaryResults* binary)
+  : m_cfg (cfg),
+    m_binary (binary),
+    m_built (false),
+    m_rank (cfg.distributed ? DistributedRank () : 0),
+    m_associations (0)
+{
+  NS_ABORT_MSG_IF (cfg.rooms == 0 || cfg.rooms > 254, "rooms must be in 1..254");
+  NS_ABORT_MSG_IF (StationsPerRoom (cfg) == 0 || StationsPerRoom (cfg) > 253,
+                   "stations per room must be in 1..253");
+  NS_ABORT_MSG_IF (cfg.robotPort == cfg.videoPort || cfg.robotPort == cfg.vitalPort || cfg.videoPort == cfg.vitalPort,
+                   "robotPort, videoPort and vitalPort must differ");
+  NS_ABORT_MSG_IF (cfg.trafficModel != "echo" && cfg.trafficModel != "surgical",
+                   "trafficModel must be echo or surgical, not " << cfg.trafficModel);
+  NS_ABORT_MSG_IF (cfg.trafficModel == "echo" && (cfg.robotDownlink || cfg.videoDownlink || cfg.vitalDownlink),
+                   "downlink flows need trafficModel=surgical");
+  NS_ABORT_MSG_IF (cfg.fidelity != "fast" && cfg.fidelity != "default" && cfg.fidelity != "high",
+                   "fidelity must be fast, default or high, not " << cfg.fidelity);
+  NS_ABORT_MSG_IF (RateControl (cfg) != "constant" && RateControl (cfg) != "minstrel" && RateControl (cfg) != "ideal",
+                   "rateControl must be constant, minstrel or ideal, not " << cfg.rateControl);
+  NS_ABORT_MSG_IF (!cfg.dataMode.empty () && RateControl (cfg) != "constant",
+                   "dataMode needs rateControl=constant");
+  NS_ABORT_MSG_IF (cfg.neighbourBss > 16, "neighbourBss must be at most 16 per room");
+  NS_ABORT_MSG_IF (cfg.neighbourBss > 0 && (cfg.backgroundStations == 0 || cfg.backgroundStations > 253),
+                   "backgroundStations must be in 1..253");
+  NS_ABORT_MSG_IF (cfg.backgroundTraffic != "onoff" && cfg.backgroundTraffic != "bulk" && cfg.backgroundTraffic != "none",
+                   "backgroundTraffic must be onoff, bulk or none, not " << cfg.backgroundTraffic);
+  NS_ABORT_MSG_IF (cfg.bssColoring != "none" && cfg.bssColoring != "distinct",
+                   "bssColoring must be none or distinct, not " << cfg.bssColoring);
+  NS_ABORT_MSG_IF (cfg.obssPdLevel != 0 && cfg.bssColoring == "none",
+                   "obssPdLevel needs bssColoring=distinct: OBSS frames are told apart by their colour");
+  NS_ABORT_MSG_IF (cfg.channelPlan != "shared" && cfg.channelPlan != "orthogonal",
+                   "channelPlan must be shared or orthogonal, not " << cfg.channelPlan);
+  NS_ABORT_MSG_IF (cfg.serverTier != "edge" && cfg.serverTier != "fog" && cfg.serverTier != "cloud",
+                   "serverTier must be edge, fog or cloud, not " << cfg.serverTier);
+  NS_ABORT_MSG_IF (cfg.distributed && DistributedSize () > 1 && cfg.channelPlan != "orthogonal",
+                   "distributed runs need channelPlan=orthogonal: a shared channel cannot be split across ranks");
+  NS_ABORT_MSG_IF (cfg.distributed && (cfg.safetyStop || cfg.windowInterval.IsStrictlyPositive () || cfg.profiling),
+                   "safetyStop, windowInterval and profiling see one rank only and are not supported distributed");
+  NS_ABORT_MSG_IF ((!cfg.telemetryUdp.empty () || cfg.telemetryHttpPort != 0) && !cfg.windowInterval.IsStrictlyPositive (),
+                   "telemetry publishes the windowed sampler's windows; set windowInterval");
+  NS_ABORT_MSG_IF (cfg.powerSave != "off" && cfg.powerSave != "psm" && cfg.powerSave != "twt",
+                   "powerSave must be off, psm or twt, not " << cfg.powerSave);
+  NS_ABORT_MSG_IF (cfg.powerSave != "off" && cfg.batteryClasses.empty (),
+                   "powerSave applies to battery stations only; list their classes in batteryClasses");
+  NS_ABORT_MSG_IF (cfg.powerSave == "twt" && (!cfg.twtWakeDuration.IsStrictlyPositive ()
+                                               || cfg.twtWakeDuration >= cfg.twtInterval),
+                   "twtWakeDuration must be positive and shorter than twtInterval");
+  NS_ABORT_MSG_IF (!cfg.batteryClasses.empty () && cfg.batteryEnergyJ <= 0,
+                   "batteryEnergyJ must be positive");
+  NS_ABORT_MSG_IF (cfg.distributed && !cfg.batteryClasses.empty (),
+                   "batteryClasses is not supported distributed: energy is read off each rank's own stations");
+  NS_ABORT_MSG_IF (cfg.realtimeSync != "BestEffort" && cfg.realtimeSync != "HardLimit",
+                   "realtimeSync must be BestEffort or HardLimit, not " << cfg.realtimeSync);
+  NS_ABORT_MSG_IF (cfg.realtime && (cfg.distributed || cfg.profiling),
+                   "realtime runs on RealtimeSimulatorImpl, which cannot be distributed or profiled");
+  NS_ABORT_MSG_IF ((cfg.tapStations > 0 || cfg.tapEdge) && !cfg.realtime,
+                   "tapStations and tapEdge carry host traffic and need realtime");
+  NS_ABORT_MSG_IF (StationsPerRoom (cfg) + 1 + cfg.tapStations > 254,
+                   "room 1's stations, AP and tapStations must fit in 192.168.1.0/24");
+  NS_ABORT_MSG_IF (cfg.tapEdge && cfg.serverTier != "edge",
+                   "tapEdge needs serverTier=edge: the host subnet overlaps the 10.x backbone");
+  NS_ABORT_MSG_IF (cfg.mobility != "static" && cfg.mobility != "waypoint" && cfg.mobility != "scripted",
+                   "mobility must be static, waypoint or scripted, not " << cfg.mobility);
+  NS_ABORT_MSG_IF (cfg.mobility == "scripted" && cfg.trajectoryFile.empty (),
+                   "mobility=scripted needs a trajectoryFile");
+  NS_ABORT_MSG_IF (cfg.mobility == "waypoint" && cfg.mobilitySpeed <= 0,
+                   "mobilitySpeed must be positive");
+  m_plan = BuildDevicePlan (cfg);
+}
+
+inline const ScenarioConfig& SurgicalScenario::GetConfig () const
+{
+  return m_cfg;
+}
+
+inline const std::vector<DeviceSpec>& SurgicalScenario::GetPlan () const
+{
+  return m_plan;
+}
+
+inline void SurgicalScenario::Build ()
+{
+  NS_ABORT_MSG_IF (m_built, "SurgicalScenario::Build () called twice");
+  RngSeedManager::SetRun (m_cfg.rngRun);
+  if (m_cfg.realtime)
+    {
+      SelectRealtimeSimulatorImpl (m_cfg.realtimeSync, m_cfg.realtimeHardLimit,
+                                   m_cfg.tapStations > 0 || m_cfg.tapEdge);
+    }
+  else if (!m_cfg.distributed)
+    {
+      SelectSimulatorImpl (m_cfg.profiling, m_cfg.profileSampleEvery);
+    }
+  CreateNodes ();
+  InstallWifi ();
+  InstallBackbone ();
+  InstallEnergy ();
+  InstallMobility ();
+  InstallNetAnim ();
+  InstallInternet ();
+  InstallApplications ();
+  InstallBackground ();
+  InstallEmulation ();
+  InstallWatchdog ();
+  m_built = true;
+}
+
+// ========== 1. Create Nodes ==========
+// Stations first (room-major, as in the device plan), then one edge server
+// per room, so a single OR keeps 0: Robot, 1: Endoscope, 2: Vital, 3: Server;
+// fog and cloud nodes follow, then neighbour BSSs and the emulation bridge
+inline void SurgicalScenario::CreateNodes ()
+{
+  // Distributed runs: each room's nodes on the room's rank, fog and cloud on 0
+  const uint32_t ranks = m_cfg.distributed ? DistributedSize () : 1;
+  const uint32_t channels = ChannelObjectCount (m_cfg);
+  for (uint32_t room = 0; room < m_cfg.rooms; ++room)
+    {
+      m_stations.Create (StationsPerRoom (m_cfg), RoomRank (room, channels, ranks));
+    }
+  for (uint32_t room = 0; room < m_cfg.rooms; ++room)
+    {
+      m_servers.Create (1, RoomRank (room, channels, ranks));
+    }
+  if (m_cfg.serverTier != "edge")
+    {
+      m_fog = CreateObject<Node> (0);
+    }
+  if (m_cfg.serverTier == "cloud")
+    {
+      m_cloud = CreateObject<Node> (0);
+    }
+  for (uint32_t room = 0; room < m_cfg.rooms; ++room)
+    {
+      m_neighbourAps.Create (m_cfg.neighbourBss, RoomRank (room, channels, ranks));
+    }
+  for (uint32_t room = 0; room < m_cfg.rooms; ++room)
+    {
+      m_backgroundStations.Create (m_cfg.neighbourBss * m_cfg.backgroundStations, RoomRank (room, channels, ranks));
+    }
+  m_tapStations.Create (m_cfg.tapStations);
+  if (m_cfg.tapEdge)
+    {
+      m_tapEdge = CreateObject<Node> ();
+    }
+}
+
+inline bool SurgicalScenario::IsLocal (Ptr<Node> node) const
+{
+  return node->GetSystemId () == m_rank;
+}
+
+inline Ptr<Node> SurgicalScenario::ServerNode (uint32_t room) const
+{
+  if (m_cloud)
+    {
+      return m_cloud;
+    }
+  return m_fog ? m_fog : m_servers.Get (room);
+}
+
+inline NodeContainer SurgicalScenario::ServerHosts () const
+{
+  NodeContainer hosts;
+  for (uint32_t room = 0; room < (m_fog ? 1 : m_cfg.rooms); ++room)
+    {
+      if (IsLocal (ServerNode (room)))
+        {
+          hosts.Add (ServerNode (room));
+        }
+    }
+  return hosts;
+}
+
+// ========== 2. Wi-Fi Setup (802.11ax) ==========
+inline void SurgicalScenario::InstallWifi ()
+{
+  YansWifiChannelHelper channelHelper = YansWifiChannelHelper::Default ();
+  const bool spectrum = (m_cfg.fidelity == "high");
+  YansWifiPhyHelper yansPhy;
+  SpectrumWifiPhyHelper spectrumPhy;
+  WifiPhyHelper& phyHelper = spectrum ? static_cast<WifiPhyHelper&> (spectrumPhy) : yansPhy;
+  phyHelper.Set ("TxPowerStart", DoubleValue (m_cfg.txPowerDbm));
+  phyHelper.Set ("TxPowerEnd", DoubleValue (m_cfg.txPowerDbm));
+  if (m_cfg.fidelity == "fast")
+    {
+      phyHelper.DisablePreambleDetectionModel ();
+    }
+
+  // Loss chain: the fidelity's base model, room walls at high fidelity,
+  // then the moving obstacles InstallMobility () adds. Without any of them
+  // the YANS default channel's own log-distance model is used as is.
+  std::vector<Ptr<PropagationLossModel>> chain;
+  if (m_cfg.fidelity == "fast")
+    {
+      Ptr<RangePropagationLossModel> range = CreateObject<RangePropagationLossModel> ();
+      range->SetAttribute ("MaxRange", DoubleValue (m_cfg.fastRange));
+      chain.push_back (range);
+    }
+  else if (spectrum || m_cfg.obstaclesPerRoom > 0)
+    {
+      chain.push_back (CreateObject<LogDistancePropagationLossModel> ());
+    }
+  if (spectrum)
+    {
+      Ptr<RoomWallLossModel> walls = CreateObject<RoomWallLossModel> ();
+      walls->SetAttribute ("Loss", DoubleValue (m_cfg.wallLossDb));
+      walls->SetAttribute ("Spacing", DoubleValue (m_cfg.roomSpacing));
+      walls->SetAttribute ("OffsetX", DoubleValue ((m_cfg.roomSpacing + g_roomSizeX) / 2));
+      walls->SetAttribute ("OffsetY", DoubleValue ((m_cfg.roomSpacing + g_roomSizeY) / 2));
+      chain.push_back (walls);
+    }
+  if (m_cfg.obstaclesPerRoom > 0)
+    {
+      m_obstacleLoss = CreateObject<ObstacleShadowingLossModel> ();
+      m_obstacleLoss->SetAttribute ("Loss", DoubleValue (m_cfg.obstacleLossDb));
+      m_obstacleLoss->SetAttribute ("Radius", DoubleValue (m_cfg.obstacleRadius));
+      m_obstacleLoss->SetAttribute ("UpdateInterval", TimeValue (m_cfg.mobilityUpdateInterval));
+      chain.push_back (m_obstacleLoss);
+    }
+  for (uint32_t i = 1; i < chain.size (); ++i)
+    {
+      chain[i - 1]->SetNext (chain[i]);
+    }
+
+  // One channel object per frequency in use: a channel delivers every
+  // frame to every PHY on it
+  const bool orthogonal = (m_cfg.channelPlan == "orthogonal");
+  std::vector<Ptr<YansWifiChannel>> channels;
+  std::vector<Ptr<SpectrumChannel>> spectrumChannels;
+  for (uint32_t i = 0; i < ChannelObjectCount (m_cfg); ++i)
+    {
+      if (spectrum)
+        {
+          Ptr<MultiModelSpectrumChannel> channel = CreateObject<MultiModelSpectrumChannel> ();
+          channel->AddPropagationLossModel (chain.front ());
+          channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+          spectrumChannels.push_back (channel);
+          continue;
+        }
+      Ptr<YansWifiChannel> channel = channelHelper.Create ();
+      if (!chain.empty ())
+        {
+          channel->SetPropagationLossModel (chain.front ());
+        }
+      channels.push_back (channel);
+    }
+
+  WifiMacHelper macHelper;
+
+  WifiHelper wifiHelper;
+  wifiHelper.SetStandard (WIFI_STANDARD_80211ax);
+  if (RateControl (m_cfg) == "minstrel")
+    {
+      wifiHelper.SetRemoteStationManager ("ns3::MinstrelHtWifiManager");
+    }
+  else if (RateControl (m_cfg) == "ideal")
+    {
+      wifiHelper.SetRemoteStationManager ("ns3::IdealWifiManager");
+    }
+  else if (m_cfg.dataMode.empty ())
+    {
+      wifiHelper.SetRemoteStationManager ("ns3::ConstantRateWifiManager");
+    }
+  else
+    {
+      wifiHelper.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                          "DataMode", StringValue (m_cfg.dataMode));
+    }
+  if (m_cfg.obssPdLevel != 0)
+    {
+      wifiHelper.SetObssPdAlgorithm ("ns3::ConstantObssPdAlgorithm", "ObssPdLevel", DoubleValue (m_cfg.obssPdLevel));
+    }
+
+  // One BSS per room, on the shared channel or on the room's own, and the
+  // room's neighbour BSSs on the same channel. With distinct colouring BSS
+  // b (rooms first, then neighbours) gets colour 1 + b % 63; stations learn
+  // it from their AP.
+  const uint32_t perRoom = StationsPerRoom (m_cfg);
+  m_apDevices.resize (m_cfg.rooms);
+  m_staDevices.resize (m_cfg.rooms);
+  m_neighbourApDevices.resize (m_cfg.rooms * m_cfg.neighbourBss);
+  m_backgroundDevices.resize (m_cfg.rooms * m_cfg.neighbourBss);
+  auto colour = [this] (const NetDeviceContainer& ap, uint32_t bss) {
+    if (m_cfg.bssColoring == "distinct")
+      {
+        Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (ap.Get (0));
+        device->GetHeConfiguration ()->SetAttribute ("BssColor", UintegerValue (1 + bss % 63));
+      }
+  };
+  for (uint32_t room = 0; room < m_cfg.rooms; ++room)
+    {
+      if (spectrum)
+        {
+          spectrumPhy.SetChannel (spectrumChannels[room % spectrumChannels.size ()]);
+        }
+      else
+        {
+          yansPhy.SetChannel (channels[room % channels.size ()]);
+        }
+      if (orthogonal)
+        {
+          uint16_t number = g_orthogonalChannels[room % g_nOrthogonalChannels];
+          phyHelper.Set ("ChannelSettings", StringValue ("{" + std::to_string (number) + ", 20, BAND_5GHZ, 0}"));
+        }
+      Ssid ssid = Ssid (m_cfg.rooms == 1 ? m_cfg.ssid : m_cfg.ssid + "-" + std::to_string (room + 1));
+
+      macHelper.SetType ("ns3::ApWifiMac", "Ssid", SsidValue (ssid));
+      m_apDevices[room] = wifiHelper.Install (phyHelper, macHelper, m_servers.Get (room));
+      colour (m_apDevices[room], room);
+
+      NodeContainer roomStations;
+      for (uint32_t i = 0; i < perRoom; ++i)
+        {
+          roomStations.Add (m_stations.Get (room * perRoom + i));
+        }
+      // Warm start: a probe request answered at once instead of waiting
+      // for the next beacon
+      macHelper.SetType ("ns3::StaWifiMac", "Ssid", SsidValue (ssid),
+                         "ActiveProbing", BooleanValue (m_cfg.warmStart),
+                         "ProbeRequestTimeout", TimeValue (MilliSeconds (m_cfg.warmStart ? 10 : 50)));
+      m_staDevices[room] = wifiHelper.Install (phyHelper, macHelper, roomStations);
+      for (uint32_t i = 0; i < m_staDevices[room].GetN (); ++i)
+        {
+          Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (m_staDevices[room].Get (i));
+          device->GetMac ()->TraceConnectWithoutContext ("Assoc", MakeCallback (&SurgicalScenario::NoteAssociation, this));
+        }
+      if (room == 0)
+        {
+          m_tapDevices = wifiHelper.Install (phyHelper, macHelper, m_tapStations);
+        }
+
+      for (uint32_t j = 0; j < m_cfg.neighbourBss; ++j)
+        {
+          uint32_t bss = room * m_cfg.neighbourBss + j;
+          Ssid neighbourSsid = Ssid ("Hospital-" + std::to_string (room + 1) + "-" + std::to_string (j + 1));
+          macHelper.SetType ("ns3::ApWifiMac", "Ssid", SsidValue (neighbourSsid));
+          m_neighbourApDevices[bss] = wifiHelper.Install (phyHelper, macHelper, m_neighbourAps.Get (bss));
+          colour (m_neighbourApDevices[bss], m_cfg.rooms + bss);
+
+          NodeContainer bssStations;
+          for (uint32_t i = 0; i < m_cfg.backgroundStations; ++i)
+            {
+              bssStations.Add (m_backgroundStations.Get (bss * m_cfg.backgroundStations + i));
+            }
+          macHelper.SetType ("ns3::StaWifiMac", "Ssid", SsidValue (neighbourSsid),
+                             "ActiveProbing", BooleanValue (m_cfg.warmStart),
+                             "ProbeRequestTimeout", TimeValue (MilliSeconds (m_cfg.warmStart ? 10 : 50)));
+          m_backgroundDevices[bss] = wifiHelper.Install (phyHelper, macHelper, bssStations);
+        }
+    }
+}
+
+// ========== 2b. Wired Backbone (fog/cloud tiers) ==========
+// Every AP gets a point-to-point link to the fog node; the cloud node hangs
+// off the fog node behind a slower, lossy WAN link
+inline void SurgicalScenario::InstallBackbone ()
+{
+  if (!m_fog)
+    {
+      return;
+    }
+  PointToPointHelper fogLink;
+  fogLink.SetDeviceAttribute ("DataRate", StringValue (m_cfg.fogLinkRate));
+  fogLink.SetChannelAttribute ("Delay", TimeValue (m_cfg.fogLinkDelay));
+  m_fogLinks.resize (m_cfg.rooms);
+  for (uint32_t room = 0; room < m_cfg.rooms; ++room)
+    {
+      m_fogLinks[room] = fogLink.Install (m_servers.Get (room), m_fog);
+    }
+
+  if (!m_cloud)
+    {
+      return;
+    }
+  PointToPointHelper cloudLink;
+  cloudLink.SetDeviceAttribute ("DataRate", StringValue (m_cfg.cloudLinkRate));
+  cloudLink.SetChannelAttribute ("Delay", TimeValue (m_cfg.cloudLinkDelay));
+  m_cloudLink = cloudLink.Install (m_fog, m_cloud);
+  if (m_cfg.cloudLinkLossPercent > 0)
+    {
+      for (uint32_t i = 0; i < m_cloudLink.GetN (); ++i)
+        {
+          Ptr<RateErrorModel> errors = CreateObject<RateErrorModel> ();
+          errors->SetAttribute ("ErrorUnit", EnumValue (RateErrorModel::ERROR_UNIT_PACKET));
+          errors->SetAttribute ("ErrorRate", DoubleValue (m_cfg.cloudLinkLossPercent / 100.0));
+          m_cloudLink.Get (i)->SetAttribute ("ReceiveErrorModel", PointerValue (errors));
+        }
+    }
+}
+
+// ========== 2c. Batteries and Power Save (Optional) ==========
+// A BasicEnergySource and WifiRadioEnergyModel per battery station; the
+// model integrates the PHY's time in TX, RX, idle, CCA busy and sleep
+inline void SurgicalScenario::InstallEnergy ()
+{
+  m_energy.resize (m_plan.size ());
+  if (m_cfg.batteryClasses.empty ())
+    {
+      return;
+    }
+  BasicEnergySourceHelper batteryHelper;
+  batteryHelper.Set ("BasicEnergySourceInitialEnergyJ", DoubleValue (m_cfg.batteryEnergyJ));
+  batteryHelper.Set ("BasicEnergySupplyVoltageV", DoubleValue (m_cfg.batteryVoltage));
+  WifiRadioEnergyModelHelper radioHelper;
+
+  const uint32_t perRoom = StationsPerRoom (m_cfg);
+  for (uint32_t room = 0; room < m_cfg.rooms; ++room)
+    {
+      uint32_t dozers = 0;  // battery stations of the room so far, for TWT staggering
+      for (uint32_t i = 0; i < perRoom; ++i)
+        {
+          uint32_t device = room * perRoom + i;
+          const DeviceSpec& d = m_plan[device];
+          if (!IsBatteryClass (m_cfg, d.deviceClass))
+            {
+              continue;
+            }
+          Ptr<NetDevice> netDevice = m_staDevices[room].Get (i);
+          energy::EnergySourceContainer battery = batteryHelper.Install (m_stations.Get (device));
+          m_energy[device] = radioHelper.Install (NetDeviceContainer (netDevice), battery).Get (0);
+
+          Ptr<WifiNetDevice> wifiDevice = DynamicCast<WifiNetDevice> (netDevice);
+          Ptr<StaWifiMac> mac = DynamicCast<StaWifiMac> (wifiDevice->GetMac ());
+          if (m_cfg.powerSave == "psm")
+            {
+              mac->SetPowerSaveMode ({true, 0});  // single-link station: link 0
+            }
+          else if (m_cfg.powerSave == "twt")
+            {
+              // A station holding a TWT agreement need not hear every beacon
+              mac->SetAttribute ("MaxMissedBeacons", UintegerValue (std::numeric_limits<uint32_t>::max ()));
+              Time offset = NanoSeconds ((dozers * m_cfg.twtWakeDuration.GetNanoSeconds ())
+                                         % m_cfg.twtInterval.GetNanoSeconds ());
+              Time start = GetTrafficProfile (m_cfg, d.deviceClass).start + offset;
+              Simulator::Schedule (start, &TwtServicePeriod, wifiDevice->GetPhy (),
+                                   m_cfg.twtWakeDuration, m_cfg.twtInterval);
+            }
+          ++dozers;
+        }
+    }
+}
+
+// Association times show how long the network takes to settle; the BSSID
+// the StaWifiMac "Assoc" trace passes is not needed
+inline void SurgicalScenario::NoteAssociation (Mac48Address)
+{
+  ++m_associations;
+  m_lastAssociation = Simulator::Now ();
+}
+
+// ========== 3. Mobility (OR layout, optionally moving) ==========
+// Every device starts at its layout position; edge servers never move
+inline void SurgicalScenario::InstallMobility ()
+{
+  std::map<std::string, std::vector<Waypoint>> trajectories;
+  if (m_cfg.mobility == "scripted")
+    {
+      trajectories = LoadTrajectoryFile (m_cfg.trajectoryFile);
+    }
+
+  uint32_t scripted = 0;
+  for (uint32_t i = 0; i < m_plan.size (); ++i)
+    {
+      const DeviceSpec& d = m_plan[i];
+      Vector position = DevicePosition (m_cfg, d);
+      Ptr<MobilityModel> model;
+      auto script = trajectories.find (d.name);
+      if (script != trajectories.end ())
+        {
+          Vector origin = RoomOrigin (m_cfg, d.room);
+          Ptr<WaypointMobilityModel> waypoints = CreateObject<WaypointMobilityModel> ();
+          if (script->second.front ().time.IsStrictlyPositive ())
+            {
+              waypoints->AddWaypoint (Waypoint (Seconds (0), position));
+            }
+          for (const auto& w : script->second)
+            {
+              waypoints->AddWaypoint (Waypoint (w.time, origin + w.position));
+            }
+          model = waypoints;
+          ++scripted;
+        }
+      else if (m_cfg.mobility == "waypoint" && IsMobileClass (m_cfg, d.deviceClass))
+        {
+          model = CreateRoomWalker (m_cfg, d.room, position);
+        }
+      else
+        {
+          model = CreateObject<ConstantPositionMobilityModel> ();
+          model->SetPosition (position);
+        }
+      m_stations.Get (i)->AggregateObject (model);
+    }
+  if (scripted < trajectories.size ())
+    {
+      NS_LOG_WARN (trajectories.size () - scripted << " trajectories in " << m_cfg.trajectoryFile
+                   << " name no device of this layout");
+    }
+
+  MobilityHelper mobility;
+  Ptr<ListPositionAllocator> posAlloc = CreateObject<ListPositionAllocator> ();
+  for (uint32_t room = 0; room < m_cfg.rooms; ++room)
+    {
+      Vector origin = RoomOrigin (m_cfg, room);
+      posAlloc->Add (Vector (origin.x + g_serverX, origin.y + g_serverY, 0.0));
+    }
+  // Fog and cloud sit left of the first room, for NetAnim only
+  if (m_fog)
+    {
+      posAlloc->Add (Vector (-5.0, g_serverY, 0.0));
+    }
+  if (m_cloud)
+    {
+      posAlloc->Add (Vector (-10.0, g_serverY, 0.0));
+    }
+  mobility.SetPositionAllocator (posAlloc);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (m_servers);
+  if (m_fog)
+    {
+      mobility.Install (m_fog);
+    }
+  if (m_cloud)
+    {
+      mobility.Install (m_cloud);
+    }
+
+  // Neighbour APs evenly spread on a circle around the room's AP, their
+  // stations on a 1 m circle around their own AP
+  Ptr<ListPositionAllocator> neighbourAlloc = CreateObject<ListPositionAllocator> ();
+  Ptr<ListPositionAllocator> backgroundAlloc = CreateObject<ListPositionAllocator> ();
+  for (uint32_t room = 0; room < m_cfg.rooms; ++room)
+    {
+      Vector origin = RoomOrigin (m_cfg, room);
+      for (uint32_t j = 0; j < m_cfg.neighbourBss; ++j)
+        {
+          double angle = 2 * M_PI * j / m_cfg.neighbourBss;
+          Vector ap (origin.x + g_serverX + m_cfg.neighbourDistance * std::cos (angle),
+                     origin.y + g_serverY + m_cfg.neighbourDistance * std::sin (angle), 0.0);
+          neighbourAlloc->Add (ap);
+          for (uint32_t i = 0; i < m_cfg.backgroundStations; ++i)
+            {
+              double a = 2 * M_PI * i / m_cfg.backgroundStations;
+              backgroundAlloc->Add (Vector (ap.x + std::cos (a), ap.y + std::sin (a), 0.0));
+            }
+        }
+    }
+  mobility.SetPositionAllocator (neighbourAlloc);
+  mobility.Install (m_neighbourAps);
+  mobility.SetPositionAllocator (backgroundAlloc);
+  mobility.Install (m_backgroundStations);
+
+  // Emulated stations in a row 1 m in front of room 1's AP; the wired tap
+  // end only has a position for NetAnim
+  Ptr<ListPositionAllocator> tapAlloc = CreateObject<ListPositionAllocator> ();
+  for (uint32_t k = 0; k < m_tapStations.GetN (); ++k)
+    {
+      tapAlloc->Add (Vector (g_serverX - 1.0 + 0.5 * k, g_serverY - 1.0, 0.0));
+    }
+  if (m_tapEdge)
+    {
+      tapAlloc->Add (Vector (g_serverX, -3.0, 0.0));
+    }
+  mobility.SetPositionAllocator (tapAlloc);
+  mobility.Install (m_tapStations);
+  if (m_tapEdge)
+    {
+      mobility.Install (m_tapEdge);
+    }
+
+  // Obstacles start spread along the middle of the room; they are no
+  // nodes, so nothing initializes them but us
+  for (uint32_t room = 0; m_obstacleLoss && room < m_cfg.rooms; ++room)
+    {
+      Vector origin = RoomOrigin (m_cfg, room);
+      for (uint32_t k = 0; k < m_cfg.obstaclesPerRoom; ++k)
+        {
+          Vector start (origin.x + g_roomSizeX * (k + 1) / (m_cfg.obstaclesPerRoom + 1),
+                        origin.y + g_roomSizeY / 2, 0.0);
+          Ptr<MobilityModel> obstacle = CreateRoomWalker (m_cfg, room, start);
+          obstacle->Initialize ();
+          m_obstacleLoss->AddObstacle (obstacle);
+          m_obstacles.push_back (obstacle);
+        }
+    }
+}
+
+// ========== 4. NetAnim (Optional) ==========
+inline void SurgicalScenario::InstallNetAnim ()
+{
+  m_anim = SetupNetAnim (m_cfg);
+  if (!m_anim)
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < m_plan.size (); ++i)
+    {
+      const DeviceClassInfo& info = g_deviceClasses[m_plan[i].deviceClass];
+      m_anim->UpdateNodeDescription (m_stations.Get (i)->GetId (), m_plan[i].name);
+      m_anim->UpdateNodeColor (m_stations.Get (i)->GetId (), info.red, info.green, info.blue);
+    }
+  std::string apLabel = m_fog ? "AP" : "Edge Server";
+  for (uint32_t room = 0; room < m_cfg.rooms; ++room)
+    {
+      m_anim->UpdateNodeDescription (m_servers.Get (room)->GetId (),
+                                     m_cfg.rooms == 1 ? apLabel : apLabel + " " + std::to_string (room + 1));
+      m_anim->UpdateNodeColor (m_servers.Get (room)->GetId (), 128, 128, 128);
+    }
+  if (m_fog)
+    {
+      m_anim->UpdateNodeDescription (m_fog->GetId (), "Fog");
+    }
+  if (m_cloud)
+    {
+      m_anim->UpdateNodeDescription (m_cloud->GetId (), "Cloud");
+    }
+  for (uint32_t i = 0; i < m_neighbourAps.GetN (); ++i)
+    {
+      m_anim->UpdateNodeDescription (m_neighbourAps.Get (i)->GetId (), "Hospital AP");
+      m_anim->UpdateNodeColor (m_neighbourAps.Get (i)->GetId (), 200, 200, 200);
+    }
+  for (uint32_t i = 0; i < m_backgroundStations.GetN (); ++i)
+    {
+      m_anim->UpdateNodeColor (m_backgroundStations.Get (i)->GetId (), 200, 200, 200);
+    }
+}
+
+// ========== 5. Internet Stack ==========
+inline void SurgicalScenario::InstallInternet ()
+{
+  InternetStackHelper stack;
+  stack.Install (m_stations);
+  stack.Install (m_servers);
+  if (m_fog)
+    {
+      stack.Install (m_fog);
+    }
+  if (m_cloud)
+    {
+      stack.Install (m_cloud);
+    }
+  stack.Install (m_neighbourAps);
+  stack.Install (m_backgroundStations);
+  stack.Install (m_tapStations);
+
+  // One /24 per room: 192.168.<room + 1>.0, stations first, AP last
+  Ipv4AddressHelper address;
+  address.SetBase ("192.168.1.0", "255.255.255.0");
+  m_serverAddress.resize (m_cfg.rooms);
+  for (uint32_t room = 0; room < m_cfg.rooms; ++room)
+    {
+      Ipv4InterfaceContainer staInterfaces = address.Assign (m_staDevices[room]);
+      for (uint32_t i = 0; i < staInterfaces.GetN (); ++i)
+        {
+          m_stationAddress.push_back (staInterfaces.GetAddress (i));
+        }
+      Ipv4InterfaceContainer apInterface = address.Assign (m_apDevices[room]);
+      m_serverAddress[room] = apInterface.GetAddress (0);
+      address.NewNetwork ();
+    }
+  // Emulated stations follow room 1's AP; their host taps take these addresses
+  if (m_tapStations.GetN () > 0)
+    {
+      Ipv4AddressHelper tapAddress;
+      tapAddress.SetBase ("192.168.1.0", "255.255.255.0",
+                          ("0.0.0." + std::to_string (StationsPerRoom (m_cfg) + 2)).c_str ());
+      tapAddress.Assign (m_tapDevices);
+    }
+
+  // Backbone: 10.1.<room + 1>.0 for AP-fog links, 10.2.1.0 for fog-cloud;
+  // servers are then addressed by their fog or cloud address
+  if (m_fog)
+    {
+      Ipv4AddressHelper backbone;
+      backbone.SetBase ("10.1.1.0", "255.255.255.0");
+      for (uint32_t room = 0; room < m_cfg.rooms; ++room)
+        {
+          Ipv4InterfaceContainer link = backbone.Assign (m_fogLinks[room]);
+          m_serverAddress[room] = link.GetAddress (1);
+          backbone.NewNetwork ();
+        }
+    }
+  if (m_cloud)
+    {
+      Ipv4AddressHelper wan;
+      wan.SetBase ("10.2.1.0", "255.255.255.0");
+      Ipv4InterfaceContainer link = wan.Assign (m_cloudLink);
+      for (uint32_t room = 0; room < m_cfg.rooms; ++room)
+        {
+          m_serverAddress[room] = link.GetAddress (1);
+        }
+    }
+  // Neighbour BSSs: one /24 each from 172.16.1.0, stations first, AP last;
+  // they only talk to their own AP
+  Ipv4AddressHelper hospital;
+  hospital.SetBase ("172.16.1.0", "255.255.255.0");
+  for (uint32_t bss = 0; bss < m_neighbourApDevices.size (); ++bss)
+    {
+      hospital.Assign (m_backgroundDevices[bss]);
+      m_neighbourApAddress.push_back (hospital.Assign (m_neighbourApDevices[bss]).GetAddress (0));
+      hospital.NewNetwork ();
+    }
+  if (m_fog)
+    {
+      Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+    }
+
+  // Warm start: permanent ARP entries for every address, so the first packet
+  // of each flow does not wait for an ARP exchange
+  if (m_cfg.warmStart)
+    {
+      NeighborCacheHelper neighborCache;
+      neighborCache.PopulateNeighborCache ();
+    }
+}
+
+// ========== 6. Latency Collector and Applications ==========
+inline void SurgicalScenario::InstallApplications ()
+{
+  m_collector.reset (new LatencyCollector (FLOW_DIRECTION_COUNT * m_plan.size ()));
+  m_collector->SetStampTags (m_cfg.distributed);
+  if (m_binary)
+    {
+      m_collector->SetPacketTable (&m_binary->packets, m_cfg.rngRun);
+    }
+  if (m_cfg.packetTrace)
+    {
+      m_trace.reset (new PacketTraceWriter (PacketTracePath (m_cfg, m_rank), m_cfg.rngRun,
+                                            static_cast<uint64_t> (m_cfg.packetTraceArenaKb) * 1024));
+      m_collector->SetPacketTrace (m_trace.get ());
+    }
+  if (HasMobility (m_cfg) && !m_cfg.distributed)
+    {
+      std::vector<Ptr<MobilityModel>> models;
+      std::vector<Vector> origins;
+      for (uint32_t i = 0; i < m_plan.size (); ++i)
+        {
+          models.push_back (m_stations.Get (i)->GetObject<MobilityModel> ());
+          origins.push_back (RoomOrigin (m_cfg, m_plan[i].room));
+        }
+      m_positionMap.reset (new PositionLatencyMap (models, origins, m_cfg.positionCell));
+      m_collector->SetRxCallback (MakeCallback (&PositionLatencyMap::Record, m_positionMap.get ()));
+    }
+
+  // Each edge server runs one echo server or sink per device class
+  const bool oneWay = (m_cfg.trafficModel == "surgical");
+  ApplicationContainer serverApps;
+  for (uint32_t c = 0; c < DEVICE_CLASS_COUNT; ++c)
+    {
+      uint16_t port = GetTrafficProfile (m_cfg, static_cast<DeviceClass> (c)).port;
+      if (oneWay)
+        {
+          PacketSinkHelper sink ("ns3::UdpSocketFactory",
+                                 InetSocketAddress (Ipv4Address::GetAny (), port));
+          serverApps.Add (sink.Install (ServerHosts ()));
+        }
+      else
+        {
+          UdpEchoServerHelper server (port);
+          serverApps.Add (server.Install (ServerHosts ()));
+        }
+    }
+  serverApps.Start (ServerStart (m_cfg));
+  serverApps.Stop (Seconds (m_cfg.simulationTime));
+  for (uint32_t i = 0; i < serverApps.GetN (); ++i)
+    {
+      if (oneWay)
+        {
+          m_collector->InstallSink (serverApps.Get (i));
+        }
+      else
+        {
+          m_collector->InstallServer (serverApps.Get (i));
+        }
+    }
+
+  for (uint32_t i = 0; i < m_plan.size (); ++i)
+    {
+      const DeviceClassInfo& info = g_deviceClasses[m_plan[i].deviceClass];
+      TrafficProfile profile = GetTrafficProfile (m_cfg, m_plan[i].deviceClass);
+      if (!profile.enabled)
+        {
+          continue;
+        }
+      if (oneWay)
+        {
+          InstallSurgicalSource (i, UPLINK, profile);
+          if (profile.downlink)
+            {
+              InstallSurgicalSource (i, DOWNLINK, profile);
+            }
+          continue;
+        }
+      if (!IsLocal (m_stations.Get (i)))
+        {
+          continue;
+        }
+
+      UdpEchoClientHelper client (m_serverAddress[m_plan[i].room], profile.port);
+      client.SetAttribute ("MaxPackets", UintegerValue (profile.maxPackets));
+      client.SetAttribute ("Interval", TimeValue (profile.interval));
+      client.SetAttribute ("PacketSize", UintegerValue (profile.packetSize));
+      if (m_cfg.qos)
+        {
+          client.SetAttribute ("Tos", UintegerValue (info.tos));
+        }
+      ApplicationContainer clientApps = client.Install (m_stations.Get (i));
+      m_collector->InstallClient (clientApps.Get (0), i);
+      clientApps.Start (profile.start);
+      clientApps.Stop (Seconds (m_cfg.simulationTime));
+    }
+
+  if (m_cfg.windowInterval.IsStrictlyPositive ())
+    {
+      std::vector<std::string> names;
+      std::vector<std::string> directions;
+      for (uint32_t dir = 0; dir < FLOW_DIRECTION_COUNT; ++dir)
+        {
+          for (const auto& d : m_plan)
+            {
+              bool sampled = (dir == UPLINK || GetTrafficProfile (m_cfg, d.deviceClass).downlink);
+              names.push_back (sampled ? d.name : "");
+              directions.push_back (DirectionLabel (static_cast<FlowDirection> (dir)));
+            }
+        }
+      m_sampler.reset (new WindowedSampler (*m_collector, names, directions, m_cfg.windowInterval, m_cfg.rngRun,
+                                            WantsCsv (m_cfg) ? WindowsCsvPath (m_cfg) : "",
+                                            m_binary ? &m_binary->windows : nullptr));
+      m_sampler->Start ();
+    }
+  if (!m_cfg.telemetryUdp.empty () || m_cfg.telemetryHttpPort != 0)
+    {
+      m_telemetry.reset (new TelemetryExporter (*m_sampler, m_cfg.rngRun, m_cfg.telemetryUdp,
+                                                m_cfg.telemetryHttpPort, m_cfg.telemetryInterval,
+                                                m_cfg.telemetryPoll));
+      m_telemetry->Start ();
+    }
+}
+
+inline uint32_t SurgicalScenario::FlowIndex (uint32_t device, FlowDirection direction) const
+{
+  return direction * m_plan.size () + device;
+}
+
+// One-way source for plan entry 'device': on the station towards its edge
+// server (uplink) or on the edge server towards a sink on the station (downlink)
+inline void SurgicalScenario::InstallSurgicalSource (uint32_t device, FlowDirection direction,
+                                                     const TrafficProfile& profile)
+{
+  const DeviceSpec& d = m_plan[device];
+  const DeviceClassInfo& info = g_deviceClasses[d.deviceClass];
+  Ptr<Node> sender = m_stations.Get (device);
+  Ipv4Address receiver = m_serverAddress[d.room];
+  if (direction == DOWNLINK)
+    {
+      sender = ServerNode (d.room);
+      receiver = m_stationAddress[device];
+      if (IsLocal (m_stations.Get (device)))
+        {
+          PacketSinkHelper sink ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), profile.port));
+          ApplicationContainer sinkApps = sink.Install (m_stations.Get (device));
+          sinkApps.Start (ServerStart (m_cfg));
+          sinkApps.Stop (Seconds (m_cfg.simulationTime));
+          m_collector->InstallSink (sinkApps.Get (0));
+        }
+    }
+  if (!IsLocal (sender))
+    {
+      return;
+    }
+
+  Ptr<SurgicalSource> source;
+  if (d.deviceClass == ENDOSCOPE)
+    {
+      Ptr<SurgicalVideoSource> video = CreateObject<SurgicalVideoSource> ();
+      video->SetAttribute ("FrameInterval", TimeValue (profile.interval));
+      video->SetAttribute ("PacketSize", UintegerValue (profile.packetSize));
+      video->SetAttribute ("Bitrate", DataRateValue (DataRate (static_cast<uint64_t> (m_cfg.videoBitrateMbps * 1e6))));
+      video->SetAttribute ("GopLength", UintegerValue (m_cfg.videoGopLength));
+      video->SetAttribute ("IFrameRatio", DoubleValue (m_cfg.videoIFrameRatio));
+      source = video;
+    }
+  else
+    {
+      Ptr<SurgicalPeriodicSource> periodic = CreateObject<SurgicalPeriodicSource> ();
+      periodic->SetAttribute ("Interval", TimeValue (profile.interval));
+      periodic->SetAttribute ("PacketSize", UintegerValue (profile.packetSize));
+      source = periodic;
+    }
+  source->SetAttribute ("Remote", AddressValue (InetSocketAddress (receiver, profile.port)));
+  source->SetAttribute ("Flow", UintegerValue (FlowIndex (device, direction)));
+  source->SetAttribute ("MaxPackets", UintegerValue (profile.maxPackets));
+  source->SetAttribute ("Tos", UintegerValue (m_cfg.qos ? info.tos : 0));
+  source->SetStartTime (profile.start);
+  source->SetStopTime (Seconds (m_cfg.simulationTime));
+  sender->AddApplication (source);
+  m_collector->InstallSource (source);
+}
+
+// ========== 6b. Background Load (neighbour BSSs) ==========
+// Every neighbour AP runs a sink; its stations send to it uplink, like the
+// iperf clients on the testbed. Nothing here goes through the collector.
+inline void SurgicalScenario::InstallBackground ()
+{
+  if (m_cfg.backgroundTraffic == "none")
+    {
+      return;
+    }
+  const bool bulk = (m_cfg.backgroundTraffic == "bulk");
+  const std::string factory = bulk ? "ns3::TcpSocketFactory" : "ns3::UdpSocketFactory";
+  for (uint32_t bss = 0; bss < m_neighbourAps.GetN (); ++bss)
+    {
+      Ptr<Node> ap = m_neighbourAps.Get (bss);
+      if (IsLocal (ap))
+        {
+          PacketSinkHelper sink (factory, InetSocketAddress (Ipv4Address::GetAny (), g_backgroundPort));
+          ApplicationContainer sinkApps = sink.Install (ap);
+          sinkApps.Start (ServerStart (m_cfg));
+          sinkApps.Stop (Seconds (m_cfg.simulationTime));
+          m_backgroundSinks.push_back (DynamicCast<PacketSink> (sinkApps.Get (0)));
+        }
+
+      InetSocketAddress remote (m_neighbourApAddress[bss], g_backgroundPort);
+      ApplicationContainer sourceApps;
+      for (uint32_t i = 0; i < m_cfg.backgroundStations; ++i)
+        {
+          Ptr<Node> station = m_backgroundStations.Get (bss * m_cfg.backgroundStations + i);
+          if (!IsLocal (station))
+            {
+              continue;
+            }
+          if (bulk)
+            {
+              BulkSendHelper source (factory, remote);
+              source.SetAttribute ("SendSize", UintegerValue (m_cfg.backgroundPacketSize));
+              source.SetAttribute ("MaxBytes", UintegerValue (0));
+              sourceApps.Add (source.Install (station));
+            }
+          else
+            {
+              OnOffHelper source (factory, remote);
+              source.SetConstantRate (DataRate (static_cast<uint64_t> (m_cfg.backgroundRateMbps * 1e6)),
+                                      m_cfg.backgroundPacketSize);
+              sourceApps.Add (source.Install (station));
+            }
+        }
+      sourceApps.Start (BackgroundStart (m_cfg));
+      sourceApps.Stop (Seconds (m_cfg.simulationTime));
+    }
+}
+
+// ========== 6c. Emulation Bridge (Optional) ==========
+// Host traffic enters the model through TapBridge. Each emulated station is
+// a Wi-Fi STA whose host tap <tapPrefix>sta<k> is created with the station's
+// MAC and 192.168.1.x address (ConfigureLocal): frames the host sends there
+// are sent by the STA, so they contend with the modelled devices. The edge
+// port is a CSMA link from room 1's AP to a ghost node bridged to the
+// existing tap <tapPrefix>edge (UseBridge), so the AP appears at
+// tapEdgeAddress on whatever bridge that tap is in, e.g. the Mininet-WiFi
+// OVS switch managed by the Ryu controller. Host routes are set up outside.
+inline void SurgicalScenario::InstallEmulation ()
+{
+  if (m_tapDevices.GetN () == 0 && !m_tapEdge)
+    {
+      return;
+    }
+  TapBridgeHelper tapBridge;
+  tapBridge.SetAttribute ("Mode", StringValue ("ConfigureLocal"));
+  for (uint32_t k = 0; k < m_tapStations.GetN (); ++k)
+    {
+      tapBridge.SetAttribute ("DeviceName", StringValue (m_cfg.tapPrefix + "sta" + std::to_string (k)));
+      tapBridge.Install (m_tapStations.Get (k), m_tapDevices.Get (k));
+    }
+
+  if (m_tapEdge)
+    {
+      CsmaHelper csma;
+      csma.SetChannelAttribute ("DataRate", StringValue ("1Gbps"));
+      m_tapEdgeLink = csma.Install (NodeContainer (m_servers.Get (0), m_tapEdge));
+      // The AP's port takes the one address given; the ghost node has no stack
+      Ptr<Ipv4> ipv4 = m_servers.Get (0)->GetObject<Ipv4> ();
+      int32_t iface = ipv4->AddInterface (m_tapEdgeLink.Get (0));
+      ipv4->AddAddress (iface, Ipv4InterfaceAddress (Ipv4Address (m_cfg.tapEdgeAddress.c_str ()),
+                                                     Ipv4Mask (m_cfg.tapEdgeMask.c_str ())));
+      ipv4->SetUp (iface);
+      tapBridge.SetAttribute ("Mode", StringValue ("UseBridge"));
+      tapBridge.SetAttribute ("DeviceName", StringValue (m_cfg.tapPrefix + "edge"));
+      tapBridge.Install (m_tapEdge, m_tapEdgeLink.Get (1));
+    }
+}
+
+// ========== 7. Safety Watchdog (Optional) ==========
+inline void SurgicalScenario::InstallWatchdog ()
+{
+  if (!m_cfg.safetyStop)
+    {
+      return;
+    }
+  m_watchdog.reset (new SafetyWatchdog (*m_collector, m_cfg.safetyCheckInterval,
+                                        Seconds (m_cfg.safetyLatencyMs / 1000.0),
+                                        Seconds (m_cfg.safetyTaskSec)));
+  for (uint32_t i = 0; i < m_plan.size (); ++i)
+    {
+      TrafficProfile profile = GetTrafficProfile (m_cfg, m_plan[i].deviceClass);
+      if (m_plan[i].deviceClass != ROBOT_CTRL || !profile.enabled)
+        {
+          continue;
+        }
+      m_watchdog->Watch (FlowIndex (i, UPLINK), m_plan[i].name, profile.start, profile.maxPackets);
+      if (profile.downlink)
+        {
+          m_watchdog->Watch (FlowIndex (i, DOWNLINK), m_plan[i].name + " downlink",
+                             profile.start, profile.maxPackets);
+        }
+    }
+  m_watchdog->Start ();
+}
+
+inline ScenarioResult SurgicalScenario::Run ()
+{
+  if (!m_built)
+    {
+      Build ();
+    }
+
+  // ========== 8. Run Simulation ==========
+  Simulator::Stop (Seconds (m_cfg.simulationTime));
+  if (m_cfg.realtime)
+    {
+      m_lag.reset (new RealtimeLagMonitor (m_cfg.realtimeProbe, m_cfg.realtimeLagBudgetMs));
+      m_lag->Start ();
+    }
+  auto wallStart = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  if (m_sampler)
+    {
+      m_sampler->Finish ();
+    }
+  if (m_telemetry)
+    {
+      m_telemetry->Finish ();
+    }
+
+  ScenarioResult result;
+  if (m_trace)
+    {
+      m_trace->Close ();
+      result.traceRecords = m_trace->GetRecords ();
+      result.traceStalls = m_trace->GetStalls ();
+    }
+  result.stations = m_plan.size ();
+  result.wallSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - wallStart).count ();
+  result.events = Simulator::GetEventCount ();
+  if (m_cfg.distributed)
+    {
+      // Collective: every rank must get here; rank 0 then holds all flows
+      result.events = GatherFlows (*m_collector, result.events);
+      result.systemId = m_rank;
+    }
+  result.simulatedSeconds = Simulator::Now ().GetSeconds ();
+  result.associations = m_associations;
+  result.lastAssociationSeconds = m_lastAssociation.GetSeconds ();
+  Time firstTraffic = Seconds (m_cfg.simulationTime);
+  for (uint32_t c = 0; c < DEVICE_CLASS_COUNT; ++c)
+    {
+      TrafficProfile profile = GetTrafficProfile (m_cfg, static_cast<DeviceClass> (c));
+      if (profile.enabled)
+        {
+          firstTraffic = std::min (firstTraffic, profile.start);
+        }
+    }
+  if (m_cfg.warmStart && (m_associations < m_plan.size () || m_lastAssociation > firstTraffic))
+    {
+      NS_LOG_WARN ("Warm start: " << m_associations << " of " << m_plan.size () << " stations associated, last at "
+                   << m_lastAssociation.GetSeconds () << " s; traffic sent before that was dropped. "
+                   "Raise warmStartSettle.");
+    }
+  if (m_cfg.profiling)
+    {
+      result.profile = CollectEventProfile ();
+      if (!result.profile.enabled)
+        {
+          NS_LOG_WARN ("Simulator existed before the run was built; no event profile recorded");
+        }
+    }
+  if (m_watchdog)
+    {
+      result.safety = m_watchdog->GetViolation ();
+    }
+  if (m_lag)
+    {
+      result.realtime = m_lag->GetReport ();
+      if (!result.realtime.KeptUp ())
+        {
+          NS_LOG_WARN ("Real time: p99 lag " << result.realtime.lag.GetQuantileMs (0.99) << " ms exceeds "
+                       << m_cfg.realtimeLagBudgetMs << " ms; the model is too large to run in real time");
+        }
+    }
+  if (m_collector->GetStampPool ().GetOverwritten () > 0)
+    {
+      NS_LOG_WARN (m_collector->GetStampPool ().GetOverwritten ()
+                   << " echo stamps were overwritten in flight; those packets count as lost");
+    }
+  double backgroundSeconds = result.simulatedSeconds - BackgroundStart (m_cfg).GetSeconds ();
+  for (const auto& sink : m_backgroundSinks)
+    {
+      if (backgroundSeconds > 0)
+        {
+          result.backgroundMbps += sink->GetTotalRx () * 8.0 / backgroundSeconds / 1e6;
+        }
+    }
+  ExtractMetrics (result);
+  if (m_positionMap)
+    {
+      for (const auto& c : m_positionMap->GetCells ())
+        {
+          result.positions.push_back ({m_plan[c.flow % m_plan.size ()].name,
+                                       static_cast<FlowDirection> (c.flow / m_plan.size ()),
+                                       c.cellX * m_cfg.positionCell, c.cellY * m_cfg.positionCell,
+                                       c.latency});
+        }
+    }
+
+  m_lag.reset ();
+  m_telemetry.reset ();
+  m_sampler.reset ();
+  m_anim.reset ();  // closes the XML while the simulator still exists
+  Simulator::Destroy ();
+  result.peakRssMb = PeakRssMb ();
+  return result;
+}
+
+// ========== 9. Extract Metrics ==========
+// Uplink rows of all devices first, then downlink rows
+inline void SurgicalScenario::ExtractMetrics (ScenarioResult& result) const
+{
+  for (uint32_t flowIndex = 0; flowIndex < m_collector->GetNFlows (); ++flowIndex)
+    {
+      uint32_t i = flowIndex % m_plan.size ();
+      FlowDirection direction = static_cast<FlowDirection> (flowIndex / m_plan.size ());
+      const DeviceSpec& device = m_plan[i];
+      TrafficProfile profile = GetTrafficProfile (m_cfg, device.deviceClass);
+      if (!profile.enabled || (direction == DOWNLINK && !profile.downlink))
+        {
+          continue;
+        }
+      const FlowAggregate& flow = m_collector->GetFlow (flowIndex);
+
+      double lossRate = (flow.txPackets > 0) ? 
+        (1.0 - (double)flow.rxPackets / flow.txPackets) * 100.0 : 100.0;
+
+      // Average in nanoseconds first: GetMilliSeconds () truncates to whole ms,
+      // which hides sub-millisecond Wi-Fi 6 latencies entirely
+      double avgLatencyMs = (flow.rxPackets > 0) ? 
+        (double)flow.delaySum.GetNanoSeconds () / flow.rxPackets / 1e6 : 0.0;
+
+      double avgJitterMs = (flow.rxPackets > 0) ? 
+        (double)flow.jitterSum.GetNanoSeconds () / flow.rxPackets / 1e6 : 0.0;
+
+      double taskTimeSec = 0.0;
+      if (flow.rxPackets > 0 && flow.txPackets > 0)
+        {
+          taskTimeSec = flow.timeLastRxPacket.GetSeconds() - flow.timeFirstTxPacket.GetSeconds();
+        }
+
+      bool completed = (flow.rxPackets >= profile.maxPackets);
+
+      result.devices.push_back ({
+        device.name,
+        flow.txPackets,
+        flow.rxPackets,
+        lossRate,
+        avgLatencyMs,
+        avgJitterMs,
+        taskTimeSec,
+        completed,
+        device.deviceClass,
+        device.room,
+        flow.latency,
+        direction
+      });
+      if (m_energy[i] && direction == UPLINK)
+        {
+          // Average power over the run, as if the battery went on being drained at it
+          DeviceMetrics& row = result.devices.back ();
+          row.energyJ = m_energy[i]->GetTotalEnergyConsumption ();
+          if (row.energyJ > 0 && result.simulatedSeconds > 0)
+            {
+              row.batteryLifeHours = m_cfg.batteryEnergyJ / (row.energyJ / result.simulatedSeconds) / 3600.0;
+            }
+        }
+    }
+}
+
+// Build the configured topology, run it once and extract per-device metrics
+inline ScenarioResult RunScenario (const ScenarioConfig& cfg, BinaryResults* binary = nullptr)
+{
+  return SurgicalScenario (cfg, binary).Run ();
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_SCENARIO_H */
@@ -0,0 +1,364 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Live telemetry: rolling per-device metrics published over UDP and a
+ * Prometheus endpoint while the simulation runs
+ */
+
+#ifndef SURGICAL_TELEMETRY_H
+#define SURGICAL_TELEMETRY_H
+
+#include "surgical-collector.h"
+
+namespace ns3 {
+
+// ===== Live telemetry =====
+// Every 'wallInterval' seconds of wall-clock time the exporter publishes
+// where the run is (simulated time, events per wall second) and each
+// device's most recent window from the WindowedSampler. The fields are
+// those naso/tracer_logger.py writes to network_trace.csv on the Mininet
+// testbed, so one dashboard reads both:
+//   timestamp         simulated seconds (testbed: seconds since start)
+//   latency_ms        mean one-way delay in the window (testbed: ping avg)
+//   jitter_ms         mean delay variation in the window (testbed: ping mdev)
+//   loss_pct          window loss
+//   bandwidth_mbps    delivered throughput in the window
+//   delta_tx_bytes, delta_rx_bytes   bytes sent and received in the window
+//   congestion_state  LOW/MEDIUM/HIGH, calculate_state_label's latency and
+//                     loss thresholds
+// queue_drops, rssi_dbm, server_cpu_pct and server_ram_pct are not modelled
+// and sent as null. Each record also names the run, device and direction
+// and adds sim_time_s, wall_time_s, events_per_s, sim_speed (simulated
+// seconds per wall second), window_start_s and p99_latency_ms.
+//
+// With a UDP target every device is one JSON datagram per publication;
+// with an HTTP port the same values are served as Prometheus gauges
+// (surgical_latency_ms{run,device,direction} ...) on any path by a
+// background thread. The simulator side only looks at the wall clock once
+// every 'poll' of simulated time, so an idle exporter costs one event per
+// poll.
+
+class TelemetryExporter
+{
+public:
+  // 'udpTarget' is host:port (empty = no UDP), 'httpPort' 0 = no endpoint
+  TelemetryExporter (const WindowedSampler& sampler, uint32_t rngRun, const std::string& udpTarget,
+                     uint16_t httpPort, double wallInterval, Time poll);
+  ~TelemetryExporter ();
+
+  void Start ();
+  // Publish the final windows and stop the HTTP thread; call after the
+  // sampler's Finish ()
+  void Finish ();
+
+  uint64_t GetPublications () const;
+
+private:
+  void Poll ();
+  void Publish ();
+  void OpenUdp (const std::string& target);
+  void OpenHttp (uint16_t port);
+  void ServeLoop ();
+  void StopServer ();
+
+  const WindowedSampler& m_sampler;
+  uint32_t m_rngRun;
+  double m_wallInterval;
+  Time m_poll;
+  std::chrono::steady_clock::time_point m_wallStart;
+  std::chrono::steady_clock::time_point m_lastPublish;
+  uint64_t m_lastEvents;
+  double m_lastSimSeconds;
+  uint64_t m_publications;
+  EventId m_pollEvent;
+
+  int m_udp;  // connected datagram socket, -1 without a target
+  bool m_udpFailed;
+
+  // The HTTP thread serves the last page the simulator rendered
+  int m_listen;  // -1 without an endpoint
+  std::mutex m_mutex;
+  std::string m_page;
+  std::atomic<bool> m_closing;
+  std::thread m_server;
+};
+
+// tracer_logger.py's calculate_state_label on what a simulation measures
+inline const char* CongestionState (double latencyMs, double lossPct)
+{
+  if (latencyMs > 50 || lossPct > 5)
+    {
+      return "HIGH";
+    }
+  return (latencyMs > 20 || lossPct > 1) ? "MEDIUM" : "LOW";
+}
+
+inline TelemetryExporter::TelemetryExporter (const WindowedSampler& sampler, uint32_t rngRun,
+                                             const std::string& udpTarget, uint16_t httpPort,
+                                             double wallInterval, Time poll)
+  : m_sampler (sampler),
+    m_rngRun (rngRun),
+    m_wallInterval (wallInterval),
+    m_poll (poll),
+    m_lastEvents (0),
+    m_lastSimSeconds (0.0),
+    m_publications (0),
+    m_udp (-1),
+    m_udpFailed (false),
+    m_listen (-1),
+    m_closing (false)
+{
+  NS_ABORT_MSG_IF (wallInterval <= 0, "the telemetry interval must be positive");
+  NS_ABORT_MSG_IF (!poll.IsStrictlyPositive (), "the telemetry poll interval must be positive");
+  if (!udpTarget.empty ())
+    {
+      OpenUdp (udpTarget);
+    }
+  if (httpPort != 0)
+    {
+      OpenHttp (httpPort);
+    }
+}
+
+// Without Finish () nothing more is published: the simulator may be gone
+inline TelemetryExporter::~TelemetryExporter ()
+{
+  StopServer ();
+  if (m_udp >= 0)
+    {
+      ::close (m_udp);
+    }
+}
+
+inline void TelemetryExporter::OpenUdp (const std::string& target)
+{
+  size_t colon = target.rfind (':');
+  if (colon == std::string::npos || colon + 1 == target.size ())
+    {
+      NS_FATAL_ERROR ("telemetryUdp must be host:port, not " << target);
+    }
+  std::string host = target.substr (0, colon);
+  std::string port = target.substr (colon + 1);
+  struct addrinfo hints;
+  std::memset (&hints, 0, sizeof (hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  struct addrinfo* address = nullptr;
+  int error = getaddrinfo (host.empty () ? "127.0.0.1" : host.c_str (), port.c_str (), &hints, &address);
+  if (error != 0)
+    {
+      NS_FATAL_ERROR ("Cannot resolve telemetry target " << target << ": " << gai_strerror (error));
+    }
+  m_udp = ::socket (AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+  if (m_udp < 0 || ::connect (m_udp, address->ai_addr, address->ai_addrlen) != 0)
+    {
+      freeaddrinfo (address);
+      NS_FATAL_ERROR ("Cannot open a telemetry socket to " << target << ": " << std::strerror (errno));
+    }
+  freeaddrinfo (address);
+}
+
+// A busy port (another sweep worker has it) only loses the endpoint
+inline void TelemetryExporter::OpenHttp (uint16_t port)
+{
+  m_listen = ::socket (AF_INET, SOCK_STREAM, 0);
+  int on = 1;
+  setsockopt (m_listen, SOL_SOCKET, SO_REUSEADDR, &on, sizeof (on));
+  struct sockaddr_in address;
+  std::memset (&address, 0, sizeof (address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl (INADDR_ANY);
+  address.sin_port = htons (port);
+  if (::bind (m_listen, reinterpret_cast<struct sockaddr*> (&address), sizeof (address)) != 0
+      || ::listen (m_listen, 4) != 0)
+    {
+      NS_LOG_WARN ("Cannot serve telemetry on port " << port << ": " << std::strerror (errno)
+                   << "; only UDP telemetry is published");
+      ::close (m_listen);
+      m_listen = -1;
+      return;
+    }
+  m_server = std::thread (&TelemetryExporter::ServeLoop, this);
+}
+
+inline void TelemetryExporter::Start ()
+{
+  m_wallStart = std::chrono::steady_clock::now ();
+  m_lastPublish = m_wallStart;
+  m_lastEvents = Simulator::GetEventCount ();
+  m_lastSimSeconds = Simulator::Now ().GetSeconds ();
+  m_pollEvent = Simulator::Schedule (m_poll, &TelemetryExporter::Poll, this);
+}
+
+inline void TelemetryExporter::Poll ()
+{
+  if (std::chrono::duration<double> (std::chrono::steady_clock::now () - m_lastPublish).count () >= m_wallInterval)
+    {
+      Publish ();
+    }
+  m_pollEvent = Simulator::Schedule (m_poll, &TelemetryExporter::Poll, this);
+}
+
+inline void TelemetryExporter::Finish ()
+{
+  if (m_closing)
+    {
+      return;
+    }
+  Simulator::Cancel (m_pollEvent);
+  Publish ();
+  StopServer ();
+}
+
+inline void TelemetryExporter::StopServer ()
+{
+  m_closing = true;
+  if (m_server.joinable ())
+    {
+      m_server.join ();
+    }
+  if (m_listen >= 0)
+    {
+      ::close (m_listen);
+      m_listen = -1;
+    }
+}
+
+inline void TelemetryExporter::Publish ()
+{
+  auto now = std::chrono::steady_clock::now ();
+  double wallSeconds = std::chrono::duration<double> (now - m_wallStart).count ();
+  double sinceLast = std::chrono::duration<double> (now - m_lastPublish).count ();
+  double simSeconds = Simulator::Now ().GetSeconds ();
+  uint64_t events = Simulator::GetEventCount ();
+  double eventsPerSec = (sinceLast > 0) ? (events - m_lastEvents) / sinceLast : 0.0;
+  double simSpeed = (sinceLast > 0) ? (simSeconds - m_lastSimSeconds) / sinceLast : 0.0;
+  m_lastPublish = now;
+  m_lastEvents = events;
+  m_lastSimSeconds = simSeconds;
+  ++m_publications;
+
+  std::ostringstream page;
+  page << std::fixed << std::setprecision (6);
+  page << "# TYPE surgical_sim_time_seconds gauge\n"
+       << "surgical_sim_time_seconds{run=\"" << m_rngRun << "\"} " << simSeconds << "\n"
+       << "# TYPE surgical_wall_time_seconds gauge\n"
+       << "surgical_wall_time_seconds{run=\"" << m_rngRun << "\"} " << wallSeconds << "\n"
+       << "# TYPE surgical_events_per_second gauge\n"
+       << "surgical_events_per_second{run=\"" << m_rngRun << "\"} " << eventsPerSec << "\n"
+       << "# TYPE surgical_sim_speed gauge\n"
+       << "surgical_sim_speed{run=\"" << m_rngRun << "\"} " << simSpeed << "\n";
+  std::ostringstream gauges[8];
+  static const char* names[8] = {"latency_ms", "jitter_ms", "loss_pct", "bandwidth_mbps", "delta_tx_bytes",
+                                 "delta_rx_bytes", "p99_latency_ms", "congestion_level"};
+
+  for (uint32_t flow = 0; flow < m_sampler.GetNFlows (); ++flow)
+    {
+      const WindowSample* w = m_sampler.GetLatest (flow);
+      if (!w)
+        {
+          continue;
+        }
+      const std::string& device = m_sampler.GetName (flow);
+      const std::string& direction = m_sampler.GetDirection (flow);
+      const char* state = CongestionState (w->avgLatencyMs, w->lossRate);
+      if (m_udp >= 0)
+        {
+          std::ostringstream record;
+          record << std::fixed << std::setprecision (6)
+                 << "{\"timestamp\":" << simSeconds << ",\"latency_ms\":" << w->avgLatencyMs
+                 << ",\"jitter_ms\":" << w->avgJitterMs << ",\"loss_pct\":" << w->lossRate
+                 << ",\"bandwidth_mbps\":" << w->throughputKbps / 1000.0
+                 << ",\"queue_drops\":null,\"delta_tx_bytes\":" << w->txBytes << ",\"delta_rx_bytes\":" << w->rxBytes
+                 << ",\"rssi_dbm\":null,\"server_cpu_pct\":null,\"server_ram_pct\":null"
+                 << ",\"congestion_state\":\"" << state << "\""
+                 << ",\"source\":\"ns3\",\"run\":" << m_rngRun << ",\"device\":\"" << device
+                 << "\",\"direction\":\"" << direction << "\",\"sim_time_s\":" << simSeconds
+                 << ",\"wall_time_s\":" << wallSeconds << ",\"events_per_s\":" << eventsPerSec
+                 << ",\"sim_speed\":" << simSpeed << ",\"window_start_s\":" << w->startSec
+                 << ",\"p99_latency_ms\":" << w->p99LatencyMs << "}";
+          std::string datagram = record.str ();
+          // Nobody listening is not an error: the dashboard may come later
+          if (::send (m_udp, datagram.data (), datagram.size (), 0) < 0 && errno != EAGAIN
+              && errno != ECONNREFUSED && !m_udpFailed)
+            {
+              m_udpFailed = true;
+              NS_LOG_WARN ("Telemetry datagram not sent: " << std::strerror (errno));
+            }
+        }
+      std::string labels = "{run=\"" + std::to_string (m_rngRun) + "\",device=\"" + device
+        + "\",direction=\"" + direction + "\"} ";
+      double values[8] = {w->avgLatencyMs, w->avgJitterMs, w->lossRate, w->throughputKbps / 1000.0,
+                          (double)w->txBytes, (double)w->rxBytes, w->p99LatencyMs,
+                          (state[0] == 'L') ? 0.0 : (state[0] == 'M') ? 1.0 : 2.0};
+      for (uint32_t g = 0; g < 8; ++g)
+        {
+          gauges[g] << std::fixed << std::setprecision (6) << "surgical_" << names[g] << labels << values[g] << "\n";
+        }
+    }
+  for (uint32_t g = 0; g < 8; ++g)
+    {
+      // congestion_level: 0 LOW, 1 MEDIUM, 2 HIGH
+      page << "# TYPE surgical_" << names[g] << " gauge\n" << gauges[g].str ();
+    }
+
+  if (m_listen >= 0)
+    {
+      std::lock_guard<std::mutex> lock (m_mutex);
+      m_page = page.str ();
+    }
+}
+
+// One request per connection, answered with the current page whatever
+// the path; the listening socket is polled so Finish () is seen promptly
+inline void TelemetryExporter::ServeLoop ()
+{
+  while (!m_closing)
+    {
+      struct pollfd listening = {m_listen, POLLIN, 0};
+      if (poll (&listening, 1, 200) <= 0)
+        {
+          continue;
+        }
+      int client = ::accept (m_listen, nullptr, nullptr);
+      if (client < 0)
+        {
+          continue;
+        }
+      struct timeval timeout = {1, 0};
+      setsockopt (client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+      setsockopt (client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof (timeout));
+      char request[1024];
+      if (::recv (client, request, sizeof (request), 0) > 0)
+        {
+          std::string body;
+          {
+            std::lock_guard<std::mutex> lock (m_mutex);
+            body = m_page;
+          }
+          std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+            + std::to_string (body.size ()) + "\r\nConnection: close\r\n\r\n" + body;
+          const char* data = response.data ();
+          size_t bytes = response.size ();
+          while (bytes > 0)
+            {
+              ssize_t n = ::send (client, data, bytes, MSG_NOSIGNAL);
+              if (n <= 0)
+                {
+                  break;
+                }
+              data += n;
+              bytes -= n;
+            }
+        }
+      ::close (client);
+    }
+}
+
+inline uint64_t TelemetryExporter::GetPublications () const
+{
+  return m_publications;
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_TELEMETRY_H */
@@ -0,0 +1,259 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Append-only per-packet trace: fixed-width binary records written from a
+ * fixed arena by a background thread
+ */
+
+#ifndef SURGICAL_TRACE_H
+#define SURGICAL_TRACE_H
+
+#include "surgical-common.h"
+
+namespace ns3 {
+
+// ===== Per-packet trace =====
+// One record per packet sent and one per packet received, so a post-mortem
+// sees every packet of every flow without FlowMonitor's per-flow caps or an
+// end-of-run dump. A send record has rx_time_ns = -1; joining send and
+// receive records on (run, flow, seq) gives each packet's delay, and send
+// records without a partner are the lost packets.
+//
+// The simulator thread only copies records into the current block of an
+// arena allocated once up front. A full block is handed to a writer thread
+// that appends it to the file with one write (2); the simulator goes on
+// filling the next block. Only when every block is still waiting to be
+// written does the simulator wait (counted as a stall), so records are never
+// dropped and the heap never grows with the run.
+//
+// File: a 16-byte header ("SIPTRACE", version, record size) followed by
+// packed little-endian records, readable with
+//   numpy.fromfile (path, offset=16, dtype=[('tx_time_ns', '<i8'),
+//     ('rx_time_ns', '<i8'), ('run', '<u4'), ('flow', '<u4'),
+//     ('seq', '<u4'), ('size', '<u4')])
+// Later runs append to the same file; a partial record left by a killed
+// writer is cut off when the file is reopened.
+
+struct PacketTraceRecord {
+  int64_t txTimeNs;
+  int64_t rxTimeNs;  // -1 on the send record
+  uint32_t run;      // RngRun
+  uint32_t flow;     // collector flow index
+  uint32_t seq;      // per-flow sequence number
+  uint32_t size;     // bytes
+};
+
+static_assert (sizeof (PacketTraceRecord) == 32, "trace records must stay 32 bytes on disk");
+
+class PacketTraceWriter
+{
+public:
+  // Trace run 'run' into 'path' through an arena of 'arenaBytes' cut into 'blocks' blocks
+  PacketTraceWriter (const std::string& path, uint32_t run, uint64_t arenaBytes, uint32_t blocks = 4);
+  ~PacketTraceWriter ();
+
+  void Append (uint32_t flow, uint32_t seq, uint32_t size, int64_t txTimeNs, int64_t rxTimeNs);
+  // Write what is buffered and stop the writer thread; called by the destructor
+  void Close ();
+
+  uint64_t GetRecords () const;
+  // Times the simulator waited for the writer thread
+  uint64_t GetStalls () const;
+
+private:
+  static const uint32_t HEADER_SIZE = 16;
+
+  void Submit ();
+  void WriterLoop ();
+
+  std::string m_path;
+  uint32_t m_run;
+  int m_fd;
+  std::vector<PacketTraceRecord> m_arena;
+  std::vector<uint32_t> m_blockFill;  // records in each handed-over block
+  uint32_t m_blocks;
+  uint32_t m_blockRecords;
+  uint32_t m_fill;      // records in the block being filled
+  uint64_t m_records;
+  uint64_t m_stalls;
+
+  // Blocks are filled and written round robin: block 'submitted % blocks'
+  // is the one being filled, blocks written..submitted-1 wait for the writer
+  std::mutex m_mutex;
+  std::condition_variable m_submittedCv;
+  std::condition_variable m_writtenCv;
+  uint64_t m_submitted;
+  uint64_t m_written;
+  bool m_closing;
+  int m_error;  // errno of the first failed write, reported by Close ()
+  std::thread m_writer;
+};
+
+inline PacketTraceWriter::PacketTraceWriter (const std::string& path, uint32_t run, uint64_t arenaBytes,
+                                             uint32_t blocks)
+  : m_path (path),
+    m_run (run),
+    m_fd (-1),
+    m_blocks (blocks),
+    m_blockRecords (arenaBytes / sizeof (PacketTraceRecord) / blocks),
+    m_fill (0),
+    m_records (0),
+    m_stalls (0),
+    m_submitted (0),
+    m_written (0),
+    m_closing (false),
+    m_error (0)
+{
+  NS_ABORT_MSG_IF (blocks < 2 || m_blockRecords == 0,
+                   "a " << arenaBytes << " byte trace arena is too small for " << blocks << " blocks");
+  m_arena.resize (static_cast<size_t> (m_blockRecords) * blocks);
+  m_blockFill.resize (blocks, 0);
+
+  m_fd = open (path.c_str (), O_RDWR | O_CREAT, 0644);
+  if (m_fd < 0)
+    {
+      NS_FATAL_ERROR ("Cannot open packet trace " << path << ": " << std::strerror (errno));
+    }
+  char header[HEADER_SIZE] = {'S', 'I', 'P', 'T', 'R', 'A', 'C', 'E'};
+  const uint32_t version = 1;
+  const uint32_t recordSize = sizeof (PacketTraceRecord);
+  std::memcpy (header + 8, &version, 4);
+  std::memcpy (header + 12, &recordSize, 4);
+
+  struct stat st;
+  fstat (m_fd, &st);
+  if (st.st_size < HEADER_SIZE)
+    {
+      if (ftruncate (m_fd, 0) != 0 || pwrite (m_fd, header, HEADER_SIZE, 0) != HEADER_SIZE)
+        {
+          NS_FATAL_ERROR ("Cannot write the packet trace header of " << path);
+        }
+    }
+  else
+    {
+      char existing[HEADER_SIZE];
+      if (pread (m_fd, existing, HEADER_SIZE, 0) != HEADER_SIZE || std::memcmp (existing, header, HEADER_SIZE) != 0)
+        {
+          NS_FATAL_ERROR (path << " exists but is not a packet trace written by this tool");
+        }
+      // Drop any partial record left behind by an interrupted write
+      off_t whole = HEADER_SIZE + (st.st_size - HEADER_SIZE) / recordSize * recordSize;
+      if (whole != st.st_size && ftruncate (m_fd, whole) != 0)
+        {
+          NS_FATAL_ERROR ("Cannot trim the partial record at the end of " << path);
+        }
+    }
+  lseek (m_fd, 0, SEEK_END);
+  m_writer = std::thread (&PacketTraceWriter::WriterLoop, this);
+}
+
+inline PacketTraceWriter::~PacketTraceWriter ()
+{
+  Close ();
+}
+
+inline void PacketTraceWriter::Append (uint32_t flow, uint32_t seq, uint32_t size, int64_t txTimeNs,
+                                       int64_t rxTimeNs)
+{
+  PacketTraceRecord& r = m_arena[(m_submitted % m_blocks) * m_blockRecords + m_fill];
+  r.txTimeNs = txTimeNs;
+  r.rxTimeNs = rxTimeNs;
+  r.run = m_run;
+  r.flow = flow;
+  r.seq = seq;
+  r.size = size;
+  ++m_records;
+  if (++m_fill == m_blockRecords)
+    {
+      Submit ();
+    }
+}
+
+// Hand the current block to the writer and wait for the next one to be free
+inline void PacketTraceWriter::Submit ()
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  m_blockFill[m_submitted % m_blocks] = m_fill;
+  ++m_submitted;
+  m_fill = 0;
+  m_submittedCv.notify_one ();
+  if (m_submitted - m_written >= m_blocks)
+    {
+      ++m_stalls;
+      m_writtenCv.wait (lock, [this] { return m_submitted - m_written < m_blocks; });
+    }
+}
+
+inline void PacketTraceWriter::WriterLoop ()
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (true)
+    {
+      m_submittedCv.wait (lock, [this] { return m_written < m_submitted || m_closing; });
+      if (m_written == m_submitted)
+        {
+          return;
+        }
+      uint32_t block = m_written % m_blocks;
+      const char* data = reinterpret_cast<const char*> (&m_arena[static_cast<size_t> (block) * m_blockRecords]);
+      size_t bytes = static_cast<size_t> (m_blockFill[block]) * sizeof (PacketTraceRecord);
+      lock.unlock ();
+      while (bytes > 0 && m_error == 0)
+        {
+          ssize_t n = write (m_fd, data, bytes);
+          if (n < 0 && errno != EINTR)
+            {
+              m_error = errno;
+            }
+          else if (n > 0)
+            {
+              data += n;
+              bytes -= n;
+            }
+        }
+      lock.lock ();
+      ++m_written;
+      m_writtenCv.notify_one ();
+    }
+}
+
+inline void PacketTraceWriter::Close ()
+{
+  if (!m_writer.joinable ())
+    {
+      return;
+    }
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    if (m_fill > 0)
+      {
+        // The writer drains every submitted block before it exits, so the
+        // last one needs no free block after it
+        m_blockFill[m_submitted % m_blocks] = m_fill;
+        ++m_submitted;
+        m_fill = 0;
+      }
+    m_closing = true;
+  }
+  m_submittedCv.notify_one ();
+  m_writer.join ();
+  close (m_fd);
+  m_fd = -1;
+  if (m_error != 0)
+    {
+      NS_LOG_ERROR ("Packet trace " << m_path << " is incomplete: " << std::strerror (m_error));
+    }
+}
+
+inline uint64_t PacketTraceWriter::GetRecords () const
+{
+  return m_records;
+}
+
+inline uint64_t PacketTraceWriter::GetStalls () const
+{
+  return m_stalls;
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_TRACE_H */
@@ -0,0 +1,289 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * One-way surgical traffic sources: periodic (haptic control, vitals) and
+ * frame-based video with GOP structure
+ */
+
+#ifndef SURGICAL_TRAFFIC_H
+#define SURGICAL_TRAFFIC_H
+
+#include "surgical-collector.h"
+
+namespace ns3 {
+
+// ===== Surgical traffic sources =====
+// Unlike UdpEchoClient nothing comes back, so each flow costs its own
+// airtime only. Every packet starts with a SurgicalHeader (flow, sequence
+// number, send time) and is reported on the "Tx" trace once it is handed
+// to the socket; the sink side is a plain PacketSink.
+
+class SurgicalSource : public Application
+{
+public:
+  static TypeId GetTypeId ();
+  SurgicalSource ();
+
+protected:
+  void DoDispose () override;
+
+  // Send one packet of 'size' bytes, SurgicalHeader included; returns false
+  // (and sends nothing) once MaxPackets packets are out
+  bool SendPacket (uint32_t size);
+  // First send, at the application start time
+  virtual void StartSending () = 0;
+
+  EventId m_sendEvent;
+
+private:
+  void StartApplication () override;
+  void StopApplication () override;
+
+  Address m_peer;
+  uint32_t m_flow;
+  uint32_t m_maxPackets;
+  uint8_t m_tos;
+  Ptr<Socket> m_socket;
+  uint32_t m_sent;
+  TracedCallback<Ptr<const Packet>> m_txTrace;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (SurgicalSource);
+
+inline TypeId SurgicalSource::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::SurgicalSource")
+    .SetParent<Application> ()
+    .AddAttribute ("Remote", "Destination address and port",
+                   AddressValue (),
+                   MakeAddressAccessor (&SurgicalSource::m_peer),
+                   MakeAddressChecker ())
+    .AddAttribute ("Flow", "Collector flow index written into every header",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&SurgicalSource::m_flow),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxPackets", "Packets to send before stopping",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&SurgicalSource::m_maxPackets),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Tos", "IPv4 TOS byte of every packet",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&SurgicalSource::m_tos),
+                   MakeUintegerChecker<uint8_t> ())
+    .AddTraceSource ("Tx", "A packet was sent",
+                     MakeTraceSourceAccessor (&SurgicalSource::m_txTrace),
+                     "ns3::Packet::TracedCallback");
+  return tid;
+}
+
+inline SurgicalSource::SurgicalSource ()
+  : m_flow (0),
+    m_maxPackets (0),
+    m_tos (0),
+    m_sent (0)
+{
+}
+
+inline void SurgicalSource::DoDispose ()
+{
+  m_socket = nullptr;
+  Application::DoDispose ();
+}
+
+inline void SurgicalSource::StartApplication ()
+{
+  if (!m_socket)
+    {
+      m_socket = Socket::CreateSocket (GetNode (), UdpSocketFactory::GetTypeId ());
+      m_socket->SetIpTos (m_tos);
+      m_socket->Bind ();
+      m_socket->Connect (m_peer);
+    }
+  StartSending ();
+}
+
+inline void SurgicalSource::StopApplication ()
+{
+  Simulator::Cancel (m_sendEvent);
+  if (m_socket)
+    {
+      m_socket->Close ();
+    }
+}
+
+inline bool SurgicalSource::SendPacket (uint32_t size)
+{
+  if (m_sent >= m_maxPackets)
+    {
+      return false;
+    }
+  SurgicalHeader header;
+  header.m_flow = m_flow;
+  header.m_seq = m_sent++;
+  header.m_txTime = Simulator::Now ();
+  Ptr<Packet> packet = Create<Packet> (size - std::min (size, header.GetSerializedSize ()));
+  packet->AddHeader (header);
+  m_txTrace (packet);
+  m_socket->Send (packet);
+  return true;
+}
+
+// Fixed-rate source: haptic/robot control at 1 kHz with tiny payloads, or
+// vital-sign samples once a second
+class SurgicalPeriodicSource : public SurgicalSource
+{
+public:
+  static TypeId GetTypeId ();
+  SurgicalPeriodicSource ();
+
+private:
+  void StartSending () override;
+  void Send ();
+
+  Time m_interval;
+  uint32_t m_packetSize;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (SurgicalPeriodicSource);
+
+inline TypeId SurgicalPeriodicSource::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::SurgicalPeriodicSource")
+    .SetParent<SurgicalSource> ()
+    .AddConstructor<SurgicalPeriodicSource> ()
+    .AddAttribute ("Interval", "Time between packets",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&SurgicalPeriodicSource::m_interval),
+                   MakeTimeChecker ())
+    .AddAttribute ("PacketSize", "UDP payload bytes, SurgicalHeader included",
+                   UintegerValue (32),
+                   MakeUintegerAccessor (&SurgicalPeriodicSource::m_packetSize),
+                   MakeUintegerChecker<uint32_t> ());
+  return tid;
+}
+
+inline SurgicalPeriodicSource::SurgicalPeriodicSource ()
+  : m_packetSize (32)
+{
+}
+
+inline void SurgicalPeriodicSource::StartSending ()
+{
+  Send ();
+}
+
+inline void SurgicalPeriodicSource::Send ()
+{
+  if (SendPacket (m_packetSize))
+    {
+      m_sendEvent = Simulator::Schedule (m_interval, &SurgicalPeriodicSource::Send, this);
+    }
+}
+
+// Encoded video: one frame every FrameInterval, the first of each GOP an
+// I-frame IFrameRatio times the size of a P-frame, sizes chosen so the mean
+// rate is Bitrate and varied uniformly by +/- FrameSizeVariation. A frame is
+// cut into PacketSize fragments sent back to back, so every I-frame is a
+// burst of dozens of MTU-sized packets.
+class SurgicalVideoSource : public SurgicalSource
+{
+public:
+  static TypeId GetTypeId ();
+  SurgicalVideoSource ();
+
+  int64_t AssignStreams (int64_t stream) override;
+
+private:
+  void StartSending () override;
+  void SendFrame ();
+
+  Time m_frameInterval;
+  uint32_t m_packetSize;
+  DataRate m_bitrate;
+  uint32_t m_gopLength;
+  double m_iFrameRatio;
+  double m_variation;
+  Ptr<UniformRandomVariable> m_frameSize;
+  uint32_t m_frame;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (SurgicalVideoSource);
+
+inline TypeId SurgicalVideoSource::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::SurgicalVideoSource")
+    .SetParent<SurgicalSource> ()
+    .AddConstructor<SurgicalVideoSource> ()
+    .AddAttribute ("FrameInterval", "Time between frames (1/60 s for 1080p60)",
+                   TimeValue (MicroSeconds (16667)),
+                   MakeTimeAccessor (&SurgicalVideoSource::m_frameInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("PacketSize", "Largest fragment, SurgicalHeader included",
+                   UintegerValue (1400),
+                   MakeUintegerAccessor (&SurgicalVideoSource::m_packetSize),
+                   MakeUintegerChecker<uint32_t> (64))
+    .AddAttribute ("Bitrate", "Mean encoded bit rate",
+                   DataRateValue (DataRate ("8Mbps")),
+                   MakeDataRateAccessor (&SurgicalVideoSource::m_bitrate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("GopLength", "Frames per group of pictures (one I-frame each)",
+                   UintegerValue (30),
+                   MakeUintegerAccessor (&SurgicalVideoSource::m_gopLength),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("IFrameRatio", "I-frame size relative to a P-frame",
+                   DoubleValue (6.0),
+                   MakeDoubleAccessor (&SurgicalVideoSource::m_iFrameRatio),
+                   MakeDoubleChecker<double> (1.0))
+    .AddAttribute ("FrameSizeVariation", "Relative frame size spread, uniform +/-",
+                   DoubleValue (0.2),
+                   MakeDoubleAccessor (&SurgicalVideoSource::m_variation),
+                   MakeDoubleChecker<double> (0.0, 1.0));
+  return tid;
+}
+
+inline SurgicalVideoSource::SurgicalVideoSource ()
+  : m_packetSize (1400),
+    m_gopLength (30),
+    m_iFrameRatio (6.0),
+    m_variation (0.2),
+    m_frame (0)
+{
+  m_frameSize = CreateObject<UniformRandomVariable> ();
+}
+
+inline int64_t SurgicalVideoSource::AssignStreams (int64_t stream)
+{
+  m_frameSize->SetStream (stream);
+  return 1;
+}
+
+inline void SurgicalVideoSource::StartSending ()
+{
+  SendFrame ();
+}
+
+inline void SurgicalVideoSource::SendFrame ()
+{
+  // Mean frame = rate * interval; with one I-frame of ratio r per GOP of N,
+  // P = mean * N / (r + N - 1)
+  double meanBytes = m_bitrate.GetBitRate () / 8.0 * m_frameInterval.GetSeconds ();
+  double pBytes = meanBytes * m_gopLength / (m_iFrameRatio + m_gopLength - 1);
+  double bytes = (m_frame % m_gopLength == 0) ? m_iFrameRatio * pBytes : pBytes;
+  bytes *= m_frameSize->GetValue (1.0 - m_variation, 1.0 + m_variation);
+  ++m_frame;
+
+  uint32_t remaining = std::max<uint32_t> (1, static_cast<uint32_t> (bytes));
+  while (remaining > 0)
+    {
+      uint32_t fragment = std::min (remaining, m_packetSize);
+      if (!SendPacket (fragment))
+        {
+          return;
+        }
+      remaining -= fragment;
+    }
+  m_sendEvent = Simulator::Schedule (m_frameInterval, &SurgicalVideoSource::SendFrame, this);
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_TRAFFIC_H */
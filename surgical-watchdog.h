@@ -0,0 +1,135 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * In-simulation safety watchdog: stops a run once it is conclusively unsafe
+ */
+
+#ifndef SURGICAL_WATCHDOG_H
+#define SURGICAL_WATCHDOG_H
+
+#include "surgical-collector.h"
+
+namespace ns3 {
+
+// ===== Safety watchdog =====
+// Every check interval the watchdog looks at the collector's running totals
+// of each watched (robotic control) flow and stops the simulation as soon as
+// the end-of-run safety assessment can no longer pass:
+//  - more than 1% of the flow's target packets are already above the latency
+//    limit, so its p99 over at most 'target' packets must exceed the limit;
+//  - the task limit has elapsed since the first packet was sent (or was due)
+//    and the flow has not delivered its target, so the task is late or
+//    incomplete whatever happens next.
+// Only histogram buckets lying entirely above the limit count as late, so a
+// stop is never triggered by bucket rounding.
+
+struct SafetyViolation {
+  bool stopped = false;
+  Time time;           // simulation time of the stop
+  std::string device;
+  std::string cause;   // no commas: it goes into the sweep CSV as is
+};
+
+class SafetyWatchdog
+{
+public:
+  SafetyWatchdog (const LatencyCollector& collector, Time interval,
+                  Time latencyLimit, Time taskLimit);
+
+  // Watch 'flow', named 'device', whose client starts at 'start' and is done
+  // after 'target' packets
+  void Watch (uint32_t flow, const std::string& device, Time start, uint32_t target);
+  void Start ();
+
+  const SafetyViolation& GetViolation () const;
+
+private:
+  struct WatchedFlow {
+    uint32_t flow;
+    std::string device;
+    Time start;
+    uint32_t target;
+  };
+
+  void Check ();
+  void Stop (const WatchedFlow& w, const std::string& cause);
+
+  const LatencyCollector& m_collector;
+  Time m_interval;
+  Time m_latencyLimit;
+  Time m_taskLimit;
+  std::vector<WatchedFlow> m_flows;
+  SafetyViolation m_violation;
+};
+
+inline SafetyWatchdog::SafetyWatchdog (const LatencyCollector& collector, Time interval,
+                                       Time latencyLimit, Time taskLimit)
+  : m_collector (collector),
+    m_interval (interval),
+    m_latencyLimit (latencyLimit),
+    m_taskLimit (taskLimit)
+{
+  NS_ABORT_MSG_IF (!interval.IsStrictlyPositive (), "safety check interval must be positive");
+}
+
+inline void SafetyWatchdog::Watch (uint32_t flow, const std::string& device, Time start, uint32_t target)
+{
+  m_flows.push_back ({flow, device, start, target});
+}
+
+inline void SafetyWatchdog::Start ()
+{
+  if (!m_flows.empty ())
+    {
+      Simulator::Schedule (m_interval, &SafetyWatchdog::Check, this);
+    }
+}
+
+inline const SafetyViolation& SafetyWatchdog::GetViolation () const
+{
+  return m_violation;
+}
+
+inline void SafetyWatchdog::Check ()
+{
+  Time now = Simulator::Now ();
+  for (const auto& w : m_flows)
+    {
+      const FlowAggregate& f = m_collector.GetFlow (w.flow);
+
+      uint64_t late = f.latency.GetCountAbove (m_latencyLimit.GetNanoSeconds ());
+      if (late > w.target / 100)
+        {
+          std::ostringstream cause;
+          cause << "p99 latency over " << m_latencyLimit.GetNanoSeconds () / 1e6 << " ms ("
+                << late << " of " << w.target << " packets late)";
+          Stop (w, cause.str ());
+          return;
+        }
+
+      Time taskStart = (f.txPackets > 0) ? f.timeFirstTxPacket : w.start;
+      if (f.rxPackets < w.target && now - taskStart >= m_taskLimit)
+        {
+          std::ostringstream cause;
+          cause << "task not done " << m_taskLimit.GetSeconds () << " s after start ("
+                << f.rxPackets << " of " << w.target << " packets delivered)";
+          Stop (w, cause.str ());
+          return;
+        }
+    }
+  Simulator::Schedule (m_interval, &SafetyWatchdog::Check, this);
+}
+
+inline void SafetyWatchdog::Stop (const WatchedFlow& w, const std::string& cause)
+{
+  m_violation.stopped = true;
+  m_violation.time = Simulator::Now ();
+  m_violation.device = w.device;
+  m_violation.cause = cause;
+  NS_LOG_WARN ("Safety watchdog stopped the run at " << m_violation.time.GetSeconds ()
+               << " s: " << w.device << ": " << cause);
+  Simulator::Stop ();
+}
+
+} // namespace ns3
+
+#endif /* SURGICAL_WATCHDOG_H */